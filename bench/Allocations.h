@@ -0,0 +1,49 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts the heap allocations of a benchmark executable
+// Replaces the global operator new, so include it from exactly one source file
+
+// Allocations since the start of the process
+inline long &AllocationCount() {
+  static long count = 0;
+  return count;
+}
+
+void *operator new(std::size_t size) {
+  
+  AllocationCount() += 1;
+  
+  void *pointer = std::malloc(size == 0 ? 1 : size);
+  
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  
+  return pointer;
+  
+}
+
+void *operator new[](std::size_t size) {
+  
+  return operator new(size);
+  
+}
+
+void operator delete(void *pointer) noexcept {
+  
+  std::free(pointer);
+  
+}
+
+void operator delete[](void *pointer) noexcept {
+  
+  std::free(pointer);
+  
+}
+
+#endif // ALLOCATIONS_H
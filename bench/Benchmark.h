@@ -0,0 +1,149 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Prevents the compiler from optimizing away a benchmarked value
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Timing of a benchmarked function
+struct Measurement {
+  
+  // Average time per call in nanoseconds
+  double ns_per_call;
+  
+  // Calls timed
+  long calls;
+  
+};
+
+// Runs the function in batches until the minimum time has elapsed
+template <typename Function>
+Measurement Measure(Function function, double min_seconds = 0.5) {
+  
+  typedef std::chrono::steady_clock Clock;
+  
+  // Warming up caches and branch predictors
+  for (int n = 0; n < 100; ++n) {
+    function();
+  }
+  
+  long calls = 0;
+  long batch = 1;
+  double elapsed = 0.0;
+  
+  while (elapsed < min_seconds) {
+    
+    auto start = Clock::now();
+    
+    for (long n = 0; n < batch; ++n) {
+      function();
+    }
+    
+    elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+    calls += batch;
+    batch *= 2;
+    
+  }
+  
+  return Measurement{elapsed * 1e9 / calls, calls};
+  
+}
+
+// Runs the function in batches until the minimum time has elapsed
+// Returns the average time per call in nanoseconds
+template <typename Function>
+double MeasureNanoseconds(Function function, double min_seconds = 0.5) {
+  
+  return Measure(function, min_seconds).ns_per_call;
+  
+}
+
+// Prints one benchmark result line
+inline void Report(const char *name, double ns_per_op) {
+  printf("%-40s %12.1f ns/op %14.0f ops/s\n", name, ns_per_op, 1e9 / ns_per_op);
+}
+
+// Result of one benchmark, as written to JSON
+struct BenchmarkResult {
+  
+  std::string name;
+  
+  // Operations timed and average time per operation in nanoseconds
+  long iterations;
+  double ns_per_op;
+  
+  // Items processed per operation, such as controllers in a batched update
+  long items_per_op;
+  
+  // Heap allocations per operation
+  double allocations_per_op;
+  
+};
+
+// Writes results in the JSON layout of Google Benchmark, so runs can be compared with its tools
+// Allocations are written as the user counter allocs_per_iter
+// The benchmarks are single threaded, so cpu_time is written as the wall time
+inline bool WriteJson(const std::string &path, const std::string &executable,
+                      const std::vector<BenchmarkResult> &results) {
+  
+  FILE *file = fopen(path.c_str(), "w");
+  
+  if (file == nullptr) {
+    return false;
+  }
+  
+  fprintf(file, "{\n  \"context\": {\n    \"executable\": \"%s\",\n", executable.c_str());
+#ifdef NDEBUG
+  fprintf(file, "    \"library_build_type\": \"release\"\n  },\n");
+#else
+  fprintf(file, "    \"library_build_type\": \"debug\"\n  },\n");
+#endif
+  fprintf(file, "  \"benchmarks\": [\n");
+  
+  for (size_t n = 0; n < results.size(); ++n) {
+    
+    const BenchmarkResult &result = results[n];
+    
+    fprintf(file, "    {\n      \"name\": \"%s\",\n      \"run_name\": \"%s\",\n      \"run_type\": \"iteration\",\n",
+            result.name.c_str(), result.name.c_str());
+    fprintf(file, "      \"iterations\": %ld,\n      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n",
+            result.iterations, result.ns_per_op, result.ns_per_op);
+    fprintf(file, "      \"time_unit\": \"ns\",\n      \"items_per_second\": %.1f,\n",
+            1e9 * result.items_per_op / result.ns_per_op);
+    fprintf(file, "      \"allocs_per_iter\": %.3f\n    }%s\n", result.allocations_per_op,
+            n + 1 < results.size() ? "," : "");
+    
+  }
+  
+  fprintf(file, "  ]\n}\n");
+  
+  return fclose(file) == 0;
+  
+}
+
+// Loads one frame per line from a captured frame file
+inline std::vector<std::string> LoadFrames(const std::string &path) {
+  
+  std::vector<std::string> frames;
+  std::ifstream file(path);
+  std::string line;
+  
+  while (std::getline(file, line)) {
+    if (!line.empty()) {
+      frames.push_back(line);
+    }
+  }
+  
+  return frames;
+  
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Commands.h"
+#include "Json.h"
+
+using json = nlohmann::json;
+using namespace std;
+
+
+// The original outbound path: json object, dump() and string concatenation
+static string SerializeWithJson(double steering_angle, double throttle) {
+  
+  json msgJson;
+  msgJson["steering_angle"] = steering_angle;
+  msgJson["throttle"] = throttle;
+  
+  return "42[\"steer\"," + msgJson.dump() + "]";
+  
+}
+
+
+int main() {
+  
+  // Controller outputs in the range seen while driving
+  mt19937_64 generator(7);
+  uniform_real_distribution<double> steering(-1.5, 1.5);
+  uniform_real_distribution<double> throttle(-0.5, 1.0);
+  
+  vector<pair<double, double>> commands;
+  
+  for (int n = 0; n < 1024; ++n) {
+    commands.push_back(make_pair(steering(generator), throttle(generator)));
+  }
+  
+  // Edge cases of the layout and of the rounding: zeros, integers, the switches between fixed
+  // and scientific notation, values rounding up to the next power of ten, ties, the ends of
+  // the integer arithmetic's range and the values written with snprintf beyond it
+  const double kEdgeValues[] = {
+    0.0, -0.0, 1.0, -1.0, 0.1, 0.3, 2.5, 1e-4, 9.99999999999999e-5, 1e-5, 0.30000000000000004,
+    9.9999999999999995, 0.99999999999999994, 999999999999999.0, 999999999999999.9, 1e15, 1e16,
+    123456789012345.6, 1.5e-13, 1e-13, 9e-14, 1e-20, 1e20, 1e100, 5e-324, 2.2250738585072014e-308,
+    1.7976931348623157e308, 123456789012345.5, 123456789012344.5, 0.5, 0.125, 1.0000000000000002, 4.35, 0.000123456789012345678,
+    NAN, INFINITY, -INFINITY
+  };
+  
+  vector<pair<double, double>> checked = commands;
+  
+  for (double value : kEdgeValues) {
+    checked.push_back(make_pair(value, -value));
+  }
+  
+  // Log-uniform magnitudes across most of the double range
+  uniform_real_distribution<double> magnitude(-320.0, 308.0);
+  
+  for (int n = 0; n < 100000; ++n) {
+    checked.push_back(make_pair(pow(10.0, magnitude(generator)), -pow(10.0, magnitude(generator) / 20.0)));
+  }
+  
+  for (const auto &command : checked) {
+    
+    char buffer[kMaxSteerCommandLength];
+    WriteSteerCommand(buffer, command.first, command.second);
+    
+    string expected = SerializeWithJson(command.first, command.second);
+    
+    if (expected != buffer) {
+      cerr << "WriteSteerCommand wrote " << buffer << " instead of " << expected << endl;
+      return -1;
+    }
+    
+  }
+  
+  char buffer[kMaxSteerCommandLength];
+  WriteSteerCommand(buffer, -0.0625, 1.0 / 3.0);
+  
+  if (string(buffer) != "42[\"steer\",{\"steering_angle\":-0.0625,\"throttle\":0.333333333333333}]") {
+    cerr << "Unexpected steer command " << buffer << endl;
+    return -1;
+  }
+  
+  cout << checked.size() << " steer commands identical to json.hpp" << endl;
+  
+  double json_ns = MeasureNanoseconds([&]() {
+    for (const auto &command : commands) {
+      string msg = SerializeWithJson(command.first, command.second);
+      DoNotOptimize(msg);
+    }
+  }) / commands.size();
+  
+  double writer_ns = MeasureNanoseconds([&]() {
+    for (const auto &command : commands) {
+      char buffer[kMaxSteerCommandLength];
+      size_t length = WriteSteerCommand(buffer, command.first, command.second);
+      DoNotOptimize(buffer);
+      DoNotOptimize(length);
+    }
+  }) / commands.size();
+  
+  Report("json.hpp steer command", json_ns);
+  Report("WriteSteerCommand", writer_ns);
+  
+  return 0;
+  
+}
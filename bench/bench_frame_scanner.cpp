@@ -0,0 +1,154 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "FrameScanner.h"
+
+using namespace std;
+
+
+// The original hasData search without its string copies: three passes per frame
+static Frame ScanFrameFind(const string &s) {
+  
+  Frame frame = {nullptr, 0};
+  
+  auto found_null = s.find("null");
+  auto b1 = s.find_first_of("[");
+  auto b2 = s.find_last_of("]");
+  
+  if (found_null == string::npos && b1 != string::npos && b2 != string::npos) {
+    frame.payload = s.data() + b1;
+    frame.payload_length = b2 - b1 + 1;
+  }
+  
+  return frame;
+  
+}
+
+
+// Builds a telemetry frame carrying an image field of the given size
+static string MakeFrame(size_t image_size) {
+  
+  static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  
+  string frame = "42[\"telemetry\",{\"steering_angle\":\"-2.6675\",\"throttle\":\"0.3000\","
+                 "\"speed\":\"0.5240\",\"cte\":\"0.7585\"";
+  
+  if (image_size > 0) {
+    
+    frame += ",\"image\":\"";
+    unsigned int state = 12345;
+    
+    for (size_t n = 0; n < image_size; ++n) {
+      state = state * 1103515245 + 12345;
+      frame += kAlphabet[(state >> 16) % 64];
+    }
+    
+    frame += "\"";
+    
+  }
+  
+  return frame + "}]";
+  
+}
+
+
+// Checks every implementation against the find reference on one frame
+static bool Check(const string &frame) {
+  
+  Frame expected = ScanFrameFind(frame);
+  vector<Frame> actual = {ScanFrame(frame.data(), frame.size()), ScanFrameScalar(frame.data(), frame.size())};
+  
+#if defined(__x86_64__)
+  actual.push_back(ScanFrameSse2(frame.data(), frame.size()));
+  
+  if (HasAvx2()) {
+    actual.push_back(ScanFrameAvx2(frame.data(), frame.size()));
+  }
+#endif
+  
+  for (const Frame &result : actual) {
+    if (expected.payload != result.payload || expected.payload_length != result.payload_length) {
+      cerr << "Mismatch on frame of " << frame.size() << " bytes: " << frame << endl;
+      return false;
+    }
+  }
+  
+  return true;
+  
+}
+
+
+// Checks "null" at every offset of a frame, so that it starts in every position of a block,
+// straddles blocks and falls in the bytes after the last block, and a "nul" cut off at the end
+static bool CheckNullPositions() {
+  
+  string frame = MakeFrame(0);
+  
+  for (size_t position = 0; position + 4 <= frame.size(); ++position) {
+    if (!Check(frame.substr(0, position) + "null" + frame.substr(position))) {
+      return false;
+    }
+  }
+  
+  for (size_t length = 1; length <= frame.size(); ++length) {
+    if (!Check(frame.substr(0, length) + "nul") || !Check(frame.substr(0, length))) {
+      return false;
+    }
+  }
+  
+  return Check("42[\"manual\",{}]") && Check("42[\"telemetry\",null]") && Check("") && Check("42[]");
+  
+}
+
+
+template <typename Scanner>
+static void Run(const string &name, const string &frame, Scanner scanner) {
+  
+  double ns = MeasureNanoseconds([&]() {
+    Frame result = scanner(frame);
+    DoNotOptimize(result);
+  });
+  
+  Report(name.c_str(), ns);
+  
+}
+
+
+int main() {
+  
+  if (!CheckNullPositions()) {
+    return -1;
+  }
+  
+  const size_t kImageSizes[] = {0, 1024, 16384, 65536};
+  
+  for (size_t image_size : kImageSizes) {
+    
+    string frame = MakeFrame(image_size);
+    string label = " (" + to_string(frame.size()) + " B)";
+    
+    // Checking that all implementations agree
+    if (!Check(frame)) {
+      return -1;
+    }
+    
+    Run("find x3" + label, frame, [](const string &s) { return ScanFrameFind(s); });
+    Run("ScanFrameScalar" + label, frame, [](const string &s) { return ScanFrameScalar(s.data(), s.size()); });
+    
+#if defined(__x86_64__)
+    Run("ScanFrameSse2" + label, frame, [](const string &s) { return ScanFrameSse2(s.data(), s.size()); });
+    
+    if (HasAvx2()) {
+      Run("ScanFrameAvx2" + label, frame, [](const string &s) { return ScanFrameAvx2(s.data(), s.size()); });
+    }
+#endif
+    
+    cout << endl;
+    
+  }
+  
+  return 0;
+  
+}
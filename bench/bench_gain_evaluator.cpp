@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Controller.h"
+#include "GainEvaluator.h"
+#include "PID.h"
+#include "Simulator.h"
+
+using namespace std;
+
+// Converts MPH to meters per second, as GainEvaluator.cpp does
+static const double kMphToMetersPerSecond = 0.44704;
+
+
+// Records a drive of the application's controller on the headless simulator
+// Used when no trace recorded with pid --trace is given
+static ReplayTrace RecordDrive(long ticks) {
+  
+  Simulator simulator(DefaultTrack(), DefaultVehicleModel());
+  
+  Controller controller;
+  controller.logging = false;
+  
+  ReplayTrace trace;
+  trace.dt = simulator.TickSeconds();
+  
+  Telemetry telemetry = simulator.Observe();
+  
+  for (long n = 0; n < ticks; ++n) {
+    
+    ControlCommand command = controller.Step(telemetry);
+    
+    trace.cte.push_back(telemetry.cte);
+    trace.speed.push_back(telemetry.speed);
+    trace.steer.push_back(command.steering_angle);
+    
+    if (command.action == ControlAction::kReset) {
+      simulator.Reset();
+      telemetry = simulator.Observe();
+    }
+    
+    else {
+      telemetry = simulator.Step(command.steering_angle, command.throttle);
+    }
+    
+  }
+  
+  return trace;
+  
+}
+
+
+// Replays the trace through one candidate with the PID class itself
+// Follows the same deviation model as EvaluateCandidatesScalar, so the errors must be identical
+static double ReplayWithPID(const ReplayTrace &trace, const ReplayModel &model, double Kp, double Ki, double Kd) {
+  
+  const double heading_gain = trace.dt * model.max_steering_angle / model.wheelbase;
+  
+  PID pid;
+  pid.Init(Kp, Ki, Kd, 0.0, 0.0, 0.0);
+  
+  double heading = 0.0;
+  double offset = 0.0;
+  
+  for (size_t t = 0; t < trace.cte.size(); ++t) {
+    
+    pid.UpdateError(trace.cte[t] + offset);
+    
+    double steer = min(1.0, max(-1.0, pid.TotalError() / -model.max_steering_angle));
+    
+    double distance = trace.speed[t] * kMphToMetersPerSecond;
+    offset += distance * trace.dt * heading;
+    heading += distance * heading_gain * (steer - trace.steer[t]);
+    
+  }
+  
+  return pid.CalculateError();
+  
+}
+
+
+// Checks the evaluator against the scalar reference and the PID class, then times both paths
+// Usage: bench_gain_evaluator [trace file]
+// Without a trace file a drive of the headless simulator is replayed
+int main(int argc, char *argv[]) {
+  
+  ReplayTrace trace;
+  
+  if (argc > 1) {
+    if (!LoadReplayTrace(argv[1], trace)) {
+      cerr << "Failed to read trace file " << argv[1] << endl;
+      return -1;
+    }
+  }
+  
+  else {
+    trace = RecordDrive(4000);
+  }
+  
+  ReplayModel model = DefaultReplayModel();
+  
+  // Kp and Kd grid around the tuned gains, with a small integral gain on every other row
+  // 16 x 15 candidates leave a remainder for the scalar tail of the AVX2 kernel
+  CandidateGains candidates;
+  
+  for (int p = 0; p < 16; ++p) {
+    for (int d = 0; d < 15; ++d) {
+      candidates.Add(0.05 + p * 0.1, p % 2 == 0 ? 0.0 : 0.0005, 0.5 + d * 0.25);
+    }
+  }
+  
+  vector<double> mse(candidates.Size());
+  vector<double> scalar_mse(candidates.Size());
+  
+  EvaluateCandidates(trace, candidates, model, mse.data());
+  EvaluateCandidatesScalar(trace, candidates, model, 0, candidates.Size(), scalar_mse.data());
+  
+  for (size_t k = 0; k < candidates.Size(); ++k) {
+    
+    double pid_mse = ReplayWithPID(trace, model, candidates.kp[k], candidates.ki[k], candidates.kd[k]);
+    
+    if (memcmp(&mse[k], &scalar_mse[k], sizeof(double)) != 0 ||
+        memcmp(&scalar_mse[k], &pid_mse, sizeof(double)) != 0) {
+      cerr << "Candidate " << k << " differs: EvaluateCandidates " << mse[k] << " scalar " << scalar_mse[k]
+           << " PID " << pid_mse << endl;
+      return -1;
+    }
+    
+  }
+  
+  size_t best = min_element(mse.begin(), mse.end()) - mse.begin();
+  
+  cout << candidates.Size() << " candidates over " << trace.cte.size() << " ticks identical to the scalar path and PID"
+       << ", best P: " << candidates.kp[best] << " I: " << candidates.ki[best] << " D: " << candidates.kd[best]
+       << " MSE: " << mse[best] << endl;
+  
+  double dispatched_ns = MeasureNanoseconds([&]() {
+    EvaluateCandidates(trace, candidates, model, mse.data());
+    DoNotOptimize(mse.data());
+  }) / candidates.Size();
+  
+  double scalar_ns = MeasureNanoseconds([&]() {
+    EvaluateCandidatesScalar(trace, candidates, model, 0, candidates.Size(), scalar_mse.data());
+    DoNotOptimize(scalar_mse.data());
+  }) / candidates.Size();
+  
+  Report("EvaluateCandidatesScalar per candidate", scalar_ns);
+  Report("EvaluateCandidates per candidate", dispatched_ns);
+  
+  return 0;
+  
+}
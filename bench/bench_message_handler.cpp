@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include "MessageHandler.h"
+#include "Session.h"
+#include "StageTimer.h"
+#include "Trace.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+
+// Runs the whole message handler over the corpus, as the event loop does without the socket
+// Times the stages into the histograms as pid --latency does, unless they are nullptr
+// Returns the replies of each kind in one pass
+static vector<long> HandleCorpus(MessageHandler &handler, Session &session, const vector<string> &frames,
+                                 StageHistograms *stages) {
+  
+  vector<long> replies(4, 0);
+  
+  for (const string &frame : frames) {
+    
+    StageTimer timer(stages);
+    Reply reply;
+    
+    handler.Handle(session, frame.data(), frame.size(), reply, timer);
+    DoNotOptimize(reply);
+    
+    if (stages != nullptr) {
+      timer.Finish();
+    }
+    
+    replies[int(reply.kind)] += 1;
+    
+  }
+  
+  return replies;
+  
+}
+
+
+// Feeds recorded telemetry frames to the message handler in a tight loop
+// Reports throughput and the distribution of the time to handle one message
+// Usage: bench_message_handler [--logging] [FRAMES]
+// --logging turns on the controller's console log, which the logger thread writes to stdout,
+// so results go to stderr and stdout can be redirected to /dev/null
+int main(int argc, char *argv[]) {
+  
+  bool logging = false;
+  string path = BENCH_DATA_DIR "/telemetry_frames.txt";
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--logging") == 0) {
+      logging = true;
+    }
+    
+    else {
+      path = argv[n];
+    }
+    
+  }
+  
+  vector<string> frames = LoadFrames(path);
+  
+  if (frames.empty()) {
+    cerr << "No frames found in " << path << endl;
+    return -1;
+  }
+  
+  if (logging) {
+    Logger::Instance().Start();
+  }
+  
+  // One session with tracing and metrics off, as without --trace and /metrics scrapes
+  TraceWriter trace;
+  MessageHandler handler(trace);
+  
+  Session session(1);
+  session.controller.logging = logging;
+  
+  vector<long> replies = HandleCorpus(handler, session, frames, nullptr);
+  
+  fprintf(stderr, "%zu frames from %s, logging %s, per pass %ld steer %ld reset %ld manual %ld ignored\n",
+          frames.size(), path.c_str(), logging ? "on" : "off", replies[int(ReplyKind::kSteer)],
+          replies[int(ReplyKind::kReset)], replies[int(ReplyKind::kManual)], replies[int(ReplyKind::kNone)]);
+  
+  // Throughput without any clock reads between messages
+  double ns = MeasureNanoseconds([&]() {
+    HandleCorpus(handler, session, frames, nullptr);
+  }) / frames.size();
+  
+  fprintf(stderr, "%-40s %12.1f ns/msg %14.0f msgs/s\n", "MessageHandler::Handle", ns, 1e9 / ns);
+  
+  // Throughput with the stages timed as pid --latency does, one tick in StageTimer::kSampleInterval
+  // The difference is the cost of pid --latency
+  StageHistograms stages;
+  
+  double timed_ns = MeasureNanoseconds([&]() {
+    HandleCorpus(handler, session, frames, &stages);
+  }) / frames.size();
+  
+  fprintf(stderr, "%-40s %12.1f ns/msg %14.0f msgs/s %8.1f ns/msg overhead\n", "MessageHandler::Handle, stages timed",
+          timed_ns, 1e9 / timed_ns, timed_ns - ns);
+  
+  // Latency of each message, including the cost of reading the clock once
+  LatencyHistogram latency;
+  const long kMessages = 1000000;
+  
+  for (long n = 0; n < kMessages; ++n) {
+    
+    const string &frame = frames[n % frames.size()];
+    
+    auto start = Clock::now();
+    
+    StageTimer timer(nullptr);
+    Reply reply;
+    handler.Handle(session, frame.data(), frame.size(), reply, timer);
+    DoNotOptimize(reply);
+    
+    latency.Record(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count());
+    
+  }
+  
+  HistogramSnapshot snapshot = latency.Snapshot();
+  
+  fprintf(stderr, "Latency ns over %ld msgs: p50 %llu p90 %llu p99 %llu p99.9 %llu max %llu\n", kMessages,
+          (unsigned long long) snapshot.Percentile(0.5), (unsigned long long) snapshot.Percentile(0.9),
+          (unsigned long long) snapshot.Percentile(0.99), (unsigned long long) snapshot.Percentile(0.999),
+          (unsigned long long) snapshot.Max());
+  
+  if (logging) {
+    Logger::Instance().Stop();
+    fprintf(stderr, "Log records dropped: %llu\n", (unsigned long long) Logger::Instance().Dropped());
+  }
+  
+  return 0;
+  
+}
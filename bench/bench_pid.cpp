@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Allocations.h"
+#include "Benchmark.h"
+#include "PID.h"
+#include "PIDBank.h"
+
+using namespace std;
+
+// Minimum time per benchmark in seconds
+static double min_seconds = 0.5;
+
+// Results of the benchmarks run so far
+static vector<BenchmarkResult> results;
+
+
+// Times one operation, counts its allocations and prints the result
+// items is the number of controllers one operation processes
+template <typename Function>
+static void Run(const string &name, long items, Function function) {
+  
+  Measurement measurement = Measure(function, min_seconds);
+  
+  // Counting allocations over a separate fixed number of calls, outside the timed loop
+  const long kAllocationCalls = 1000;
+  long allocations = AllocationCount();
+  
+  for (long n = 0; n < kAllocationCalls; ++n) {
+    function();
+  }
+  
+  double allocations_per_op = double(AllocationCount() - allocations) / kAllocationCalls;
+  
+  BenchmarkResult result = {name, measurement.calls, measurement.ns_per_call, items, allocations_per_op};
+  results.push_back(result);
+  
+  printf("%-40s %12.2f ns/op %14.0f items/s %8.2f allocs/op\n", name.c_str(), result.ns_per_op,
+         1e9 * items / result.ns_per_op, allocations_per_op);
+  
+}
+
+
+// Initializes a steering controller with the application's gains and increments
+static PID MakeController() {
+  
+  PID pid;
+  pid.Init(0.05, 0.0, 0.0, 0.05, 0.0, 0.5);
+  
+  return pid;
+  
+}
+
+
+// Benchmarks each PID function on a single controller
+static void RunSingle(const vector<double> &errors) {
+  
+  size_t mask = errors.size() - 1;
+  size_t k = 0;
+  
+  PID pid = MakeController();
+  
+  Run("PID/UpdateError", 1, [&]() {
+    pid.UpdateError(errors[k++ & mask]);
+    DoNotOptimize(pid);
+  });
+  
+  Run("PID/TotalError", 1, [&]() {
+    DoNotOptimize(pid.TotalError());
+  });
+  
+  Run("PID/UpdateError+TotalError", 1, [&]() {
+    pid.UpdateError(errors[k++ & mask]);
+    DoNotOptimize(pid.TotalError());
+  });
+  
+  FloatPID float_pid;
+  float_pid.Init(0.05f, 0.0f, 0.0f, 0.05f, 0.0f, 0.5f);
+  
+  Run("FloatPID/UpdateError+TotalError", 1, [&]() {
+    float_pid.UpdateError(float(errors[k++ & mask]));
+    DoNotOptimize(float_pid.TotalError());
+  });
+  
+  FixedPID fixed_pid;
+  fixed_pid.Init(Fixed32(0.05), Fixed32(0.0), Fixed32(0.0), Fixed32(0.05), Fixed32(0.0), Fixed32(0.5));
+  
+  Run("FixedPID/UpdateError+TotalError", 1, [&]() {
+    fixed_pid.UpdateError(Fixed32(errors[k++ & mask]));
+    DoNotOptimize(fixed_pid.TotalError());
+  });
+  
+  Run("PID/CalculateSum", 1, [&]() {
+    DoNotOptimize(pid.CalculateSum());
+  });
+  
+  Run("PID/CalculateError", 1, [&]() {
+    DoNotOptimize(pid.CalculateError());
+  });
+  
+  // Twiddle resets the accumulated error, so each call gets a fresh error that improves
+  // about half the time, exercising both tuning branches
+  // The controller is restored every 1024 calls so the gains and increments stay bounded
+  PID initial = MakeController();
+  pid = initial;
+  long calls = 0;
+  
+  Run("PID/Twiddle", 1, [&]() {
+    
+    if ((++calls & 1023) == 0) {
+      pid = initial;
+    }
+    
+    double error = errors[k++ & mask];
+    
+    pid.iterations = 1;
+    pid.sum_squared_error = error * error;
+    pid.Twiddle();
+    DoNotOptimize(pid);
+    
+  });
+  
+}
+
+
+// Largest differences of a controller's outputs from the double precision controller
+struct Deviation {
+  
+  double total_error;
+  double mse;
+  
+};
+
+
+// Drives a controller of another scalar type next to a double precision one
+// Returns the largest differences of TotalError and CalculateError
+template <typename Controller>
+static Deviation CompareWithDouble(const vector<double> &errors) {
+  
+  typedef decltype(Controller().gains[0] * Controller().gains[0]) Scalar;
+  
+  PID reference;
+  Controller pid;
+  
+  reference.Init(0.2, 0.004, 3.0, 0.0, 0.0, 0.0);
+  pid.Init(Scalar(0.2), Scalar(0.004), Scalar(3.0), Scalar(0.0), Scalar(0.0), Scalar(0.0));
+  
+  Deviation deviation = {0.0, 0.0};
+  
+  for (double error : errors) {
+    
+    reference.UpdateError(error);
+    pid.UpdateError(Scalar(error));
+    
+    deviation.total_error = max(deviation.total_error, fabs(double(pid.TotalError()) - reference.TotalError()));
+    deviation.mse = max(deviation.mse, fabs(double(pid.CalculateError()) - reference.CalculateError()));
+    
+  }
+  
+  return deviation;
+  
+}
+
+
+// Checks the float and fixed-point controllers against the double precision controller
+// over the benchmark's cross track errors, and that the fixed-point accumulators saturate
+// instead of wrapping around
+// Returns false if a difference exceeds its tolerance
+static bool CheckScalarTypes(const vector<double> &errors) {
+  
+  Deviation float_deviation = CompareWithDouble<FloatPID>(errors);
+  Deviation fixed_deviation = CompareWithDouble<FixedPID>(errors);
+  
+  printf("Largest difference from double over %zu ticks: float total %.2e mse %.2e, "
+         "fixed total %.2e mse %.2e\n", errors.size(), float_deviation.total_error, float_deviation.mse,
+         fixed_deviation.total_error, fixed_deviation.mse);
+  
+  // Float keeps about 7 significant digits of an integral that grows to about 100,
+  // FixedPoint<32> rounds each operation to 2.3e-10
+  if (float_deviation.total_error > 1e-3 || float_deviation.mse > 1e-5 ||
+      fixed_deviation.total_error > 1e-6 || fixed_deviation.mse > 1e-6) {
+    cerr << "Controller outputs differ from double beyond tolerance" << endl;
+    return false;
+  }
+  
+  // Squared errors of 1e10 exceed the range of FixedPoint<32> on the first tick
+  FixedPID pid;
+  pid.Init(Fixed32(0.2), Fixed32(0.004), Fixed32(3.0), Fixed32(0.0), Fixed32(0.0), Fixed32(0.0));
+  
+  for (int tick = 0; tick < 100; ++tick) {
+    pid.UpdateError(Fixed32(1e5));
+  }
+  
+  if (!(double(pid.CalculateError()) > 0.0)) {
+    cerr << "Fixed-point squared error wrapped around" << endl;
+    return false;
+  }
+  
+  return true;
+  
+}
+
+
+// Checks that every bank kernel the CPU supports matches PID bit for bit
+// 37 controllers leave a remainder for the scalar tail of every vector width
+// Returns false on the first difference
+static bool CheckBankKernels(const vector<double> &errors) {
+  
+  const size_t kControllers = 37;
+  const BankKernel kKernels[] = {BankKernel::kScalar, BankKernel::kAvx2, BankKernel::kAvx512};
+  const char *kNames[] = {"scalar", "AVX2", "AVX-512"};
+  
+  cout << "PIDBank kernels matching PID:";
+  
+  for (int kernel = 0; kernel < 3; ++kernel) {
+    
+    if (!SupportsBankKernel(kKernels[kernel])) {
+      cout << " " << kNames[kernel] << " (unsupported)";
+      continue;
+    }
+    
+    vector<PID> pids(kControllers);
+    PIDBank bank(kControllers, kKernels[kernel]);
+    
+    for (size_t n = 0; n < kControllers; ++n) {
+      pids[n].Init(0.05 * (n + 1), 0.001 * n, 0.5 + 0.1 * n, 0.0, 0.0, 0.0);
+      bank.Init(n, pids[n]);
+    }
+    
+    vector<double> outputs(kControllers);
+    
+    for (size_t tick = 0; tick + kControllers < errors.size(); ++tick) {
+      
+      // Alternating one error per controller and the same error for all
+      if (tick % 2 == 0) {
+        bank.UpdateError(errors.data() + tick);
+        for (size_t n = 0; n < kControllers; ++n) {
+          pids[n].UpdateError(errors[tick + n]);
+        }
+      }
+      
+      else {
+        bank.UpdateError(errors[tick]);
+        for (PID &pid : pids) {
+          pid.UpdateError(errors[tick]);
+        }
+      }
+      
+      bank.TotalError(outputs.data());
+      
+      for (size_t n = 0; n < kControllers; ++n) {
+        
+        double output = pids[n].TotalError();
+        double error = pids[n].CalculateError();
+        double bank_error = bank.CalculateError(n);
+        
+        if (memcmp(&output, &outputs[n], sizeof(double)) != 0 ||
+            memcmp(&error, &bank_error, sizeof(double)) != 0) {
+          cout << endl;
+          cerr << kNames[kernel] << " kernel differs from PID on controller " << n << " at tick " << tick << endl;
+          return false;
+        }
+        
+      }
+      
+    }
+    
+    cout << " " << kNames[kernel];
+    
+  }
+  
+  cout << endl;
+  
+  return true;
+  
+}
+
+
+// Benchmarks one control step of many controllers, looping over PID objects and with PIDBank
+static void RunBatched(const vector<double> &errors, size_t size) {
+  
+  string suffix = "/" + to_string(size);
+  
+  vector<PID> pids(size, MakeController());
+  PIDBank bank(size);
+  
+  for (size_t n = 0; n < size; ++n) {
+    bank.Init(n, pids[n]);
+  }
+  
+  vector<double> step_errors(size);
+  vector<double> outputs(size);
+  size_t offset = 0;
+  
+  // A different window of cross track errors each step
+  auto next_errors = [&]() {
+    offset = (offset + 1) % (errors.size() - size);
+    copy(errors.begin() + offset, errors.begin() + offset + size, step_errors.begin());
+  };
+  
+  Run("PIDLoop/UpdateError+TotalError" + suffix, long(size), [&]() {
+    next_errors();
+    for (size_t n = 0; n < size; ++n) {
+      pids[n].UpdateError(step_errors[n]);
+      outputs[n] = pids[n].TotalError();
+    }
+    DoNotOptimize(outputs.data());
+  });
+  
+  Run("PIDBank/UpdateError+TotalError" + suffix, long(size), [&]() {
+    next_errors();
+    bank.UpdateError(step_errors.data());
+    bank.TotalError(outputs.data());
+    DoNotOptimize(outputs.data());
+  });
+  
+  Run("PIDLoop/CalculateError" + suffix, long(size), [&]() {
+    double sum = 0.0;
+    for (size_t n = 0; n < size; ++n) {
+      sum += pids[n].CalculateError();
+    }
+    DoNotOptimize(sum);
+  });
+  
+  Run("PIDBank/CalculateError" + suffix, long(size), [&]() {
+    double sum = 0.0;
+    for (size_t n = 0; n < size; ++n) {
+      sum += bank.CalculateError(n);
+    }
+    DoNotOptimize(sum);
+  });
+  
+}
+
+
+// Microbenchmarks of the PID hot functions, single and batched
+// Usage: bench_pid [--json FILE] [--min-time SECONDS]
+// --json writes the results in the JSON layout of Google Benchmark so runs can be diffed
+int main(int argc, char *argv[]) {
+  
+  string json_path;
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--json") == 0 && n + 1 < argc) {
+      json_path = argv[++n];
+    }
+    
+    else if (strcmp(argv[n], "--min-time") == 0 && n + 1 < argc) {
+      min_seconds = atof(argv[++n]);
+    }
+    
+    else {
+      cerr << "Usage: " << argv[0] << " [--json FILE] [--min-time SECONDS]" << endl;
+      return -1;
+    }
+    
+  }
+  
+  // Cross track errors in the range seen while driving
+  mt19937_64 generator(7);
+  uniform_real_distribution<double> cte(-2.0, 2.0);
+  
+  vector<double> errors(4096);
+  
+  for (double &error : errors) {
+    error = cte(generator);
+  }
+  
+  if (!CheckScalarTypes(errors) || !CheckBankKernels(errors)) {
+    return -1;
+  }
+  
+  RunSingle(errors);
+  RunBatched(errors, 64);
+  RunBatched(errors, 1024);
+  
+  if (!json_path.empty() && !WriteJson(json_path, argv[0], results)) {
+    cerr << "Could not write " << json_path << endl;
+    return -1;
+  }
+  
+  return 0;
+  
+}
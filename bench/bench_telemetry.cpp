@@ -0,0 +1,179 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "FrameScanner.h"
+#include "Json.h"
+#include "Numbers.h"
+#include "Telemetry.h"
+
+using json = nlohmann::json;
+using namespace std;
+
+
+// The original ingest path: string copies, json.hpp DOM and std::stod
+static string hasData(string s) {
+  auto found_null = s.find("null");
+  auto b1 = s.find_first_of("[");
+  auto b2 = s.find_last_of("]");
+  
+  if (found_null != string::npos) {
+    return "";
+  }
+  
+  else if (b1 != string::npos && b2 != string::npos) {
+    return s.substr(b1, b2 - b1 + 1);
+  }
+  
+  return "";
+}
+
+static Telemetry ParseWithJson(const char *data, size_t length) {
+  
+  Telemetry telemetry = {0.0, 0.0, 0.0};
+  auto s = hasData(string(data).substr(0, length));
+  
+  if (s != "") {
+    
+    auto j = json::parse(s);
+    
+    if (j[0].get<string>() == "telemetry") {
+      telemetry.cte = stod(j[1]["cte"].get<string>());
+      telemetry.speed = stod(j[1]["speed"].get<string>());
+      telemetry.steering_angle = stod(j[1]["steering_angle"].get<string>());
+    }
+    
+  }
+  
+  return telemetry;
+  
+}
+
+static Telemetry ParseInPlace(const char *data, size_t length) {
+  
+  Telemetry telemetry = {0.0, 0.0, 0.0};
+  Frame frame = ScanFrame(data, length);
+  
+  if (frame.payload != nullptr) {
+    ParseTelemetry(frame.payload, frame.payload_length, telemetry);
+  }
+  
+  return telemetry;
+  
+}
+
+
+// Adds a base64-like camera image field to every frame
+static vector<string> AddImage(const vector<string> &frames, size_t image_size) {
+  
+  static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  
+  string image;
+  unsigned int state = 12345;
+  
+  for (size_t n = 0; n < image_size; ++n) {
+    state = state * 1103515245 + 12345;
+    image += kAlphabet[(state >> 16) % 64];
+  }
+  
+  vector<string> result;
+  
+  for (const auto &frame : frames) {
+    string with_image = frame;
+    with_image.insert(with_image.size() - 2, ",\"image\":\"" + image + "\"");
+    result.push_back(with_image);
+  }
+  
+  return result;
+  
+}
+
+
+// Decodes the whole corpus once per call
+template <typename Parser>
+static double RunCorpus(const vector<string> &frames, Parser parser) {
+  
+  double ns = MeasureNanoseconds([&]() {
+    for (const auto &frame : frames) {
+      Telemetry telemetry = parser(frame.data(), frame.size());
+      DoNotOptimize(telemetry);
+    }
+  });
+  
+  return ns / frames.size();
+  
+}
+
+
+int main(int argc, char *argv[]) {
+  
+  string path = argc > 1 ? argv[1] : BENCH_DATA_DIR "/telemetry_frames.txt";
+  vector<string> frames = LoadFrames(path);
+  
+  if (frames.empty()) {
+    cerr << "No frames found in " << path << endl;
+    return -1;
+  }
+  
+  // Checking that both paths decode the same values
+  for (const auto &frame : frames) {
+    
+    Telemetry expected = ParseWithJson(frame.data(), frame.size());
+    Telemetry actual = ParseInPlace(frame.data(), frame.size());
+    
+    if (expected.cte != actual.cte || expected.speed != actual.speed ||
+        expected.steering_angle != actual.steering_angle) {
+      cerr << "Mismatch on frame " << frame << endl;
+      return -1;
+    }
+    
+  }
+  
+  cout << frames.size() << " frames from " << path << endl;
+  
+  vector<string> image_frames = AddImage(frames, 16384);
+  
+  double json_plain = RunCorpus(frames, ParseWithJson);
+  double fast_plain = RunCorpus(frames, ParseInPlace);
+  double json_image = RunCorpus(image_frames, ParseWithJson);
+  double fast_image = RunCorpus(image_frames, ParseInPlace);
+  
+  Report("json.hpp telemetry", json_plain);
+  Report("ParseTelemetry telemetry", fast_plain);
+  Report("json.hpp telemetry + 16 KB image", json_image);
+  Report("ParseTelemetry telemetry + 16 KB image", fast_image);
+  
+  cout << "Speedup: " << json_plain / fast_plain << "x (telemetry), "
+       << json_image / fast_image << "x (with image)" << endl;
+  
+  // Number conversion on the quoted values of the corpus
+  vector<string> numbers;
+  
+  for (const auto &frame : frames) {
+    Telemetry telemetry = ParseInPlace(frame.data(), frame.size());
+    numbers.push_back(to_string(telemetry.cte));
+    numbers.push_back(to_string(telemetry.speed));
+    numbers.push_back(to_string(telemetry.steering_angle));
+  }
+  
+  double stod_ns = MeasureNanoseconds([&]() {
+    for (const auto &number : numbers) {
+      DoNotOptimize(stod(number));
+    }
+  }) / numbers.size();
+  
+  double parse_ns = MeasureNanoseconds([&]() {
+    for (const auto &number : numbers) {
+      double value;
+      ParseDouble(number.data(), number.data() + number.size(), value);
+      DoNotOptimize(value);
+    }
+  }) / numbers.size();
+  
+  Report("std::stod", stod_ns);
+  Report("ParseDouble", parse_ns);
+  
+  return 0;
+  
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ThreadPool.h"
+#include "Tuning.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+
+// Runs the episodes with a static partition into one contiguous block per thread
+static double RunStatic(const Track &track, const VehicleModel &model, const vector<Gains> &candidates,
+                        const EpisodeSettings &settings, int threads, vector<double> &errors) {
+  
+  auto start = Clock::now();
+  
+  auto block = [&](int t) {
+    size_t begin = candidates.size() * t / threads;
+    size_t end = candidates.size() * (t + 1) / threads;
+    for (size_t k = begin; k < end; ++k) {
+      errors[k] = RunEpisode(track, model, candidates[k], settings);
+    }
+  };
+  
+  vector<thread> workers;
+  
+  for (int t = 1; t < threads; ++t) {
+    workers.emplace_back(block, t);
+  }
+  
+  block(0);
+  
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  
+  return chrono::duration<double>(Clock::now() - start).count();
+  
+}
+
+
+// Runs the episodes as one task each on the work-stealing pool
+static double RunPool(const Track &track, const VehicleModel &model, const vector<Gains> &candidates,
+                      const EpisodeSettings &settings, ThreadPool &pool, vector<double> &errors) {
+  
+  auto start = Clock::now();
+  RunEpisodes(track, model, candidates, settings, pool, errors);
+  
+  return chrono::duration<double>(Clock::now() - start).count();
+  
+}
+
+
+// Compares static partitioning with work stealing on a grid sweep of steering gains
+// Low gains leave the track and are reset after about a hundred ticks while good gains
+// drive the full episode, so episode lengths are as skewed as in tuning
+// Usage: bench_thread_pool [--threads N]
+int main(int argc, char *argv[]) {
+  
+  int threads = max(1u, thread::hardware_concurrency());
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--threads") == 0 && n + 1 < argc) {
+      threads = max(1, atoi(argv[++n]));
+    }
+    
+    else {
+      cerr << "Usage: " << argv[0] << " [--threads N]" << endl;
+      return -1;
+    }
+    
+  }
+  
+  Track track = DefaultTrack();
+  VehicleModel model = DefaultVehicleModel();
+  
+  EpisodeSettings settings;
+  settings.ticks = 2000;
+  settings.starts = 1;
+  
+  // Kp and Kd sweep in row-major order, so the off-track episodes share the first blocks
+  vector<Gains> candidates;
+  
+  for (int p = 0; p < 16; ++p) {
+    for (int d = 0; d < 16; ++d) {
+      candidates.push_back(Gains{p * 0.2, 0.0, d * 0.4});
+    }
+  }
+  
+  // Measuring the length of each episode on one thread
+  vector<double> lengths;
+  
+  for (const Gains &gains : candidates) {
+    auto start = Clock::now();
+    DoNotOptimize(RunEpisode(track, model, gains, settings));
+    lengths.push_back(chrono::duration<double, milli>(Clock::now() - start).count());
+  }
+  
+  double total = 0.0;
+  
+  for (double length : lengths) {
+    total += length / 1000.0;
+  }
+  
+  sort(lengths.begin(), lengths.end());
+  
+  cout << candidates.size() << " episodes, " << threads << " threads, episode ms min "
+       << lengths.front() << " median " << lengths[lengths.size() / 2] << " max " << lengths.back() << endl;
+  
+  vector<double> static_errors(candidates.size());
+  vector<double> pool_errors(candidates.size());
+  
+  ThreadPool pool(threads);
+  
+  double static_seconds = RunStatic(track, model, candidates, settings, threads, static_errors);
+  double pool_seconds = RunPool(track, model, candidates, settings, pool, pool_errors);
+  
+  // Load balance is the share of the threads' time spent running episodes
+  printf("%-40s %10.1f ms %8.1f%% load balance\n", "Static partition", static_seconds * 1e3,
+         100.0 * total / (threads * static_seconds));
+  printf("%-40s %10.1f ms %8.1f%% load balance %6ld steals\n", "Work-stealing pool", pool_seconds * 1e3,
+         100.0 * total / (threads * pool_seconds), pool.Steals());
+  
+  cout << (static_errors == pool_errors ? "Errors identical" : "Errors differ") << endl;
+  
+  return 0;
+  
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Trace.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+
+// Builds the record of one tick
+static TraceRecord MakeRecord(long tick) {
+  
+  TraceRecord record = {};
+  
+  record.timestamp = tick;
+  record.cte = 0.001 * tick;
+  record.steer = -0.0625;
+  record.throttle = 0.3;
+  record.session = 1;
+  
+  return record;
+  
+}
+
+
+// Appends records to a new trace, sleeping after every burst of records unless burst is 0
+// Returns the average time per append in nanoseconds, or a negative value if the records are not read back
+static double RunAppends(const string &path, long count, long burst, vector<double> &latencies) {
+  
+  TraceWriter trace;
+  
+  if (!trace.Open(path)) {
+    fprintf(stderr, "Failed to open trace file %s\n", path.c_str());
+    return -1.0;
+  }
+  
+  latencies.assign(count, 0.0);
+  double elapsed = 0.0;
+  
+  for (long tick = 0; tick < count; ++tick) {
+    
+    TraceRecord record = MakeRecord(tick);
+    auto before = Clock::now();
+    
+    if (!trace.Append(record)) {
+      fprintf(stderr, "Failed to append record %ld\n", tick);
+      return -1.0;
+    }
+    
+    latencies[tick] = chrono::duration<double, nano>(Clock::now() - before).count();
+    elapsed += latencies[tick];
+    
+    if (burst != 0 && (tick + 1) % burst == 0) {
+      this_thread::sleep_for(chrono::microseconds(50));
+    }
+    
+  }
+  
+  trace.Close();
+  
+  vector<TraceRecord> records;
+  bool valid = ReadTrace(path, records) && records.size() == static_cast<size_t>(count);
+  
+  for (long tick = 0; valid && tick < count; ++tick) {
+    valid = records[tick].timestamp == static_cast<uint64_t>(tick) && records[tick].session == 1;
+  }
+  
+  unlink(path.c_str());
+  
+  if (!valid) {
+    fprintf(stderr, "Trace records differ from the appended ones\n");
+    return -1.0;
+  }
+  
+  sort(latencies.begin(), latencies.end());
+  
+  return elapsed / count;
+  
+}
+
+
+// Prints the average and tail latencies of appends
+static void ReportLatencies(const char *name, double ns_per_op, const vector<double> &latencies) {
+  
+  size_t count = latencies.size();
+  
+  printf("%-40s %10.1f ns/op %8.1f ns p99 %10.1f ns p99.99 %10.1f ns max\n", name, ns_per_op,
+         latencies[count * 99 / 100], latencies[count * 9999 / 10000], latencies.back());
+  
+}
+
+
+// Appends records to traces spanning several chunks and checks that they are read back
+// Usage: bench_trace [path]
+int main(int argc, char *argv[]) {
+  
+  string path = argc > 1 ? argv[1] : "/tmp/bench_trace." + to_string(getpid()) + ".bin";
+  
+  // Crossing the chunk boundary 7 times
+  const long kRecords = 8 * TraceWriter::kChunkRecords;
+  
+  vector<double> latencies;
+  
+  // Appending as fast as possible, faster than the grower thread can keep half a chunk ahead on one core
+  double ns_per_op = RunAppends(path, kRecords, 0, latencies);
+  
+  if (ns_per_op < 0.0) {
+    return -1;
+  }
+  
+  ReportLatencies("TraceWriter::Append back to back", ns_per_op, latencies);
+  
+  // Appending in bursts with idle time between them, as the control thread does between telemetry frames
+  ns_per_op = RunAppends(path, kRecords, 64, latencies);
+  
+  if (ns_per_op < 0.0) {
+    return -1;
+  }
+  
+  ReportLatencies("TraceWriter::Append in bursts of 64", ns_per_op, latencies);
+  
+  printf("%ld records read back twice\n", kRecords);
+  
+  return 0;
+  
+}
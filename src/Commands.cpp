@@ -0,0 +1,32 @@
+#include <cstring>
+
+#include "Commands.h"
+
+
+// Copies a string literal without its terminating null
+template <size_t N>
+static char *Append(char *out, const char (&literal)[N]) {
+  
+  memcpy(out, literal, N - 1);
+  return out + N - 1;
+  
+}
+
+
+// Writes the steer SocketIO event
+// The keys are written in the same (sorted) order as json.hpp
+size_t WriteSteerCommand(char *buffer, double steering_angle, double throttle) {
+  
+  char *out = buffer;
+  
+  out = Append(out, "42[\"steer\",{\"steering_angle\":");
+  out += FormatDouble(steering_angle, out);
+  out = Append(out, ",\"throttle\":");
+  out += FormatDouble(throttle, out);
+  out = Append(out, "}]");
+  
+  *out = '\0';
+  
+  return out - buffer;
+  
+}
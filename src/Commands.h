@@ -0,0 +1,21 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <cstddef>
+
+#include "Numbers.h"
+
+// Constant SocketIO events
+const char kResetCommand[] = "42[\"reset\",{}]";
+const char kManualCommand[] = "42[\"manual\",{}]";
+
+// Longest steer command written by WriteSteerCommand including the terminating null
+const size_t kMaxSteerCommandLength = 48 + 2 * kMaxDoubleLength;
+
+// Writes the 42["steer",{"steering_angle":...,"throttle":...}] SocketIO event
+// Writes the same bytes as the json.hpp object it replaces, without allocating
+// The buffer must hold kMaxSteerCommandLength characters
+// Returns the length of the message
+size_t WriteSteerCommand(char *buffer, double steering_angle, double throttle);
+
+#endif // COMMANDS_H
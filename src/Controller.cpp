@@ -0,0 +1,231 @@
+#include <math.h>
+
+#include "Controller.h"
+#include "Logger.h"
+#include "Trace.h"
+
+
+// For converting back and forth between radians and degrees.
+static double deg2rad(double x) { return x * M_PI / 180; }
+static double rad2deg(double x) { return x * 180 / M_PI; }
+
+
+// Constructor
+Controller::Controller() : total_iterations(0), logging(true) {
+  
+  // Initializing the PID controllers
+  // Kp, Ki, Kd, Kp_inc, Ki_inc, Kd_inc
+  pid_steering.Init(0.05, 0.0, 0.0, 0.05, 0.0, 0.5);
+  pid_throttle.Init(0.2, 0.0, 3.0, 0.0, 0.0, 0.0);
+  
+}
+
+
+// Computes the command for one telemetry tick
+ControlCommand Controller::Step(const Telemetry &telemetry) {
+  
+  StageTimer timer(nullptr);
+  
+  return Step(telemetry, timer);
+  
+}
+
+
+// Computes the command for one telemetry tick, timing its stages
+// The PID updates, twiddle and logging each run as one block, so every stage boundary
+// costs a single clock read; the caller laps the logging stage after tracing the tick
+ControlCommand Controller::Step(const Telemetry &telemetry, StageTimer &timer) {
+  
+  double cte = telemetry.cte;
+  double speed = telemetry.speed;
+  double angle = telemetry.steering_angle;
+  
+  double steer_value, throttle_value, target_speed, speed_error;
+  
+  ControlCommand command;
+  command.action = ControlAction::kSteer;
+  command.trace_flags = 0;
+  
+  // Optimizing mode runs while the sum of the gain increments is greater than the set threshold
+  bool optimizing = pid_steering.CalculateSum() > kTuningThreshold;
+  
+  pid_steering.UpdateError(cte);
+  
+  // Normalizing the steering value
+  steer_value = pid_steering.TotalError() / -deg2rad(25.0);
+  
+  total_iterations += 1;
+  
+  if (optimizing) {
+    
+    command.trace_flags |= kTraceOptimizing;
+    
+    // Optimizing the PID gains while trying to maintain a constant speed
+    target_speed = kTuningSpeed;
+    speed_error = target_speed - speed;
+    pid_throttle.UpdateError(speed_error);
+    throttle_value = pid_throttle.TotalError();
+    
+  }
+  
+  else {
+    
+    target_speed = kCruiseSpeed;
+    speed_error = target_speed - speed;
+    pid_throttle.UpdateError(speed_error);
+    throttle_value = pid_throttle.TotalError() * (1.0 / (1.0 + fabs(angle)));
+    
+  }
+  
+  command.steering_angle = steer_value;
+  command.throttle = throttle_value;
+  
+  timer.Lap(kStagePidUpdate);
+  
+  if (optimizing) {
+    
+    // Resetting the simulator if the car drives off the track or gets stuck
+    // The command still carries the steering and throttle values for tracing, but is not sent
+    if (OffTrack(cte, speed)) {
+      
+      pid_steering.Twiddle();
+      pid_steering.ResetError();
+      total_iterations = 0;
+      
+      command.action = ControlAction::kReset;
+      command.trace_flags |= kTraceReset | kTraceTwiddle;
+      
+    }
+    
+    else if (total_iterations > kTwiddleTicks) {
+      
+      pid_steering.Twiddle();
+      total_iterations = 0;
+      command.trace_flags |= kTraceTwiddle;
+      
+    }
+    
+    timer.Lap(kStageTwiddle);
+    
+  }
+  
+  if (!logging) {
+    return command;
+  }
+  
+  if (optimizing) {
+    
+    LOG_DEBUG(LogEvent::kOptimizing);
+    
+    if (command.action == ControlAction::kReset) {
+      LOG_INFO(LogEvent::kResetting);
+      return command;
+    }
+    
+    if (command.trace_flags & kTraceTwiddle) {
+      LOG_INFO(LogEvent::kTwiddling);
+    }
+    
+    LOG_DEBUG(LogEvent::kErrors, pid_steering.best_error, pid_steering.CalculateError());
+    LOG_DEBUG(LogEvent::kTuning, pid_steering.i, pid_steering.order);
+    LOG_DEBUG(LogEvent::kGainIncrements, pid_steering.gain_increments[0], pid_steering.gain_increments[1], pid_steering.gain_increments[2]);
+    
+  }
+  
+  else {
+    LOG_DEBUG(LogEvent::kOptimized);
+  }
+  
+  LOG_DEBUG(LogEvent::kGains, pid_steering.gains[0], pid_steering.gains[1], pid_steering.gains[2]);
+  LOG_DEBUG(LogEvent::kControl, cte, rad2deg(steer_value), throttle_value);
+  
+  return command;
+  
+}
+
+
+// True if the car drove off the track or got stuck after the grace ticks of the episode
+bool Controller::OffTrack(double cte, double speed) const {
+  
+  return (fabs(cte) > kMaxCte || speed < kMinSpeed) && total_iterations > kResetGraceTicks;
+  
+}
+
+
+// Computes the command for one telemetry tick with fixed steering gains
+ControlCommand Controller::StepFixedGains(const Telemetry &telemetry) {
+  
+  ControlCommand command;
+  command.action = ControlAction::kSteer;
+  command.trace_flags = kTraceOptimizing;
+  
+  pid_steering.UpdateError(telemetry.cte);
+  command.steering_angle = pid_steering.TotalError() / -deg2rad(25.0);
+  
+  total_iterations += 1;
+  
+  pid_throttle.UpdateError(kTuningSpeed - telemetry.speed);
+  command.throttle = pid_throttle.TotalError();
+  
+  if (OffTrack(telemetry.cte, telemetry.speed)) {
+    command.action = ControlAction::kReset;
+    command.trace_flags |= kTraceReset;
+  }
+  
+  return command;
+  
+}
+
+
+// Starts a new episode from rest
+void Controller::Restart() {
+  
+  pid_steering.ResetError();
+  pid_throttle.ResetError();
+  total_iterations = 0;
+  
+}
+
+
+// Updates the PID errors for a tick whose command is never sent
+void Controller::Skip(const Telemetry &telemetry) {
+  
+  pid_steering.UpdateError(telemetry.cte);
+  
+  double target_speed = pid_steering.CalculateSum() > kTuningThreshold ? kTuningSpeed : kCruiseSpeed;
+  pid_throttle.UpdateError(target_speed - telemetry.speed);
+  
+  total_iterations += 1;
+  
+}
+
+
+// Appends the tick of the given simulator session to the flight trace if tracing is enabled
+void TraceTick(TraceWriter &trace, long session, PDController &pid_steering, const Telemetry &telemetry,
+               const ControlCommand &command) {
+  
+  if (!trace.IsOpen()) {
+    return;
+  }
+  
+  TraceRecord record;
+  
+  record.timestamp = TraceTimestamp();
+  record.cte = telemetry.cte;
+  record.speed = telemetry.speed;
+  record.angle = telemetry.steering_angle;
+  record.steer = command.steering_angle;
+  record.throttle = command.throttle;
+  record.gains[0] = pid_steering.gains[0];
+  record.gains[1] = pid_steering.gains[1];
+  record.gains[2] = pid_steering.gains[2];
+  record.best_error = pid_steering.best_error;
+  record.current_error = pid_steering.CalculateError();
+  record.index = pid_steering.i;
+  record.order = pid_steering.order;
+  record.flags = command.trace_flags;
+  record.session = uint32_t(session);
+  
+  trace.Append(record);
+  
+}
@@ -0,0 +1,103 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <cstdint>
+
+#include "PID.h"
+#include "StageTimer.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+// Tuning parameters, shared with the offline tuners
+// Gains are tuned while the sum of the steering gain increments is above this threshold
+const double kTuningThreshold = 0.1;
+
+// Target speed in MPH while tuning
+const double kTuningSpeed = 40.0;
+
+// The car is reset when the cross track error or speed leave these bounds
+// after the first kResetGraceTicks ticks of an episode
+const double kMaxCte = 4.5;
+const double kMinSpeed = 5.0;
+const int kResetGraceTicks = 100;
+
+// Ticks per twiddle episode
+const int kTwiddleTicks = 400;
+
+// Target speed in MPH once the gains are tuned
+const double kCruiseSpeed = 60.0;
+
+// Action requested by the controller for one telemetry tick
+enum class ControlAction {
+  kSteer,
+  kReset
+};
+
+// Output of the controller for one telemetry tick
+struct ControlCommand {
+  
+  ControlAction action;
+  
+  // Normalized steering value and throttle value
+  // Also filled in on resets for tracing, but not sent
+  double steering_angle;
+  double throttle;
+  
+  // TraceFlags describing the tick
+  uint32_t trace_flags;
+  
+};
+
+// Steering and throttle logic of the application
+// Drives the car and tunes the steering gains with twiddle while it drives
+class Controller {
+  
+private:
+  
+  // True if the car drove off the track or got stuck after the grace ticks of the episode
+  bool OffTrack(double cte, double speed) const;
+  
+public:
+  
+  // PID controllers
+  // Both run with an integral gain of 0, so the integral term is compiled out
+  PDController pid_steering;
+  PDController pid_throttle;
+  
+  // Ticks since the last twiddle or reset
+  int total_iterations;
+  
+  // Writes the per tick status to the log when true
+  bool logging;
+  
+  // Constructor
+  // Initializes the PID controllers with the application's gains
+  Controller();
+  
+  // Computes the command for one telemetry tick
+  ControlCommand Step(const Telemetry &telemetry);
+  
+  // Computes the command for one telemetry tick, timing the PID update and twiddle stages
+  // Its logging runs last, so the caller's lap of the logging stage after tracing covers it
+  ControlCommand Step(const Telemetry &telemetry, StageTimer &timer);
+  
+  // Computes the command for one telemetry tick with fixed steering gains
+  // Drives at the tuning speed and requests a reset under the same rules as optimizing mode,
+  // but never twiddles; used by the offline tuners to score a set of gains
+  ControlCommand StepFixedGains(const Telemetry &telemetry);
+  
+  // Starts a new episode from rest, clearing the PID errors and the tick count
+  void Restart();
+  
+  // Updates the PID errors for a tick whose command is never sent
+  // Used when newer telemetry is already waiting, so that the derivative and the
+  // accumulated error still cover every sample; resets and twiddles wait for the next Step
+  void Skip(const Telemetry &telemetry);
+  
+};
+
+// Appends the tick of the given simulator session to the flight trace if tracing is enabled
+void TraceTick(TraceWriter &trace, long session, PDController &pid_steering, const Telemetry &telemetry,
+               const ControlCommand &command);
+
+#endif // CONTROLLER_H
@@ -0,0 +1,22 @@
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__)
+
+// Checks if the CPU supports AVX2
+bool HasAvx2() {
+  
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+  
+}
+
+
+// Checks if the CPU supports AVX-512F
+bool HasAvx512() {
+  
+  static const bool has_avx512 = __builtin_cpu_supports("avx512f");
+  return has_avx512;
+  
+}
+
+#endif
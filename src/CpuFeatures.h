@@ -0,0 +1,17 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Vector instruction sets available at runtime
+// Each is checked once per process and shared by every kernel that dispatches on it
+
+#if defined(__x86_64__)
+
+// Checks if the CPU supports AVX2
+bool HasAvx2();
+
+// Checks if the CPU supports AVX-512F
+bool HasAvx512();
+
+#endif
+
+#endif // CPU_FEATURES_H
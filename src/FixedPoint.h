@@ -0,0 +1,101 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <cstdint>
+#include <limits>
+
+// Signed fixed-point number with FractionBits fractional bits stored in 64 bits
+// The range is +-2^(63 - FractionBits) with a resolution of 2^-FractionBits, so
+// FixedPoint<32> holds about +-2.1e9 in steps of 2.3e-10
+// Results outside the range saturate at its ends instead of wrapping around, so an
+// accumulator such as PID's sum of squared errors stops growing rather than turning negative
+// Intermediate products use 128 bits so that multiplication does not overflow
+template <int FractionBits>
+class FixedPoint {
+  
+private:
+  
+  int64_t raw;
+  
+  static const int64_t kOne = int64_t(1) << FractionBits;
+  
+  // Ends of the raw range
+  static int64_t Max() { return std::numeric_limits<int64_t>::max(); }
+  static int64_t Min() { return std::numeric_limits<int64_t>::min(); }
+  
+  // Clamps a wide intermediate result to the range
+  static FixedPoint Saturate(__int128 value) {
+    return FromRaw(value > Max() ? Max() : value < Min() ? Min() : static_cast<int64_t>(value));
+  }
+  
+  // Clamps a double, already scaled by kOne, to the range
+  static int64_t SaturateScaled(double scaled) {
+    
+    // 2^63 is the first double above the largest raw value
+    if (scaled >= 9223372036854775808.0) {
+      return Max();
+    }
+    
+    if (scaled <= -9223372036854775808.0) {
+      return Min();
+    }
+    
+    return static_cast<int64_t>(scaled);
+    
+  }
+  
+public:
+  
+  FixedPoint() : raw(0) {}
+  
+  explicit FixedPoint(double value) : raw(SaturateScaled(value * kOne + (value < 0 ? -0.5 : 0.5))) {}
+  
+  explicit FixedPoint(int value) : raw(Saturate(static_cast<__int128>(value) * kOne).raw) {}
+  
+  // Creates a number from its raw representation
+  static FixedPoint FromRaw(int64_t raw) {
+    FixedPoint result;
+    result.raw = raw;
+    return result;
+  }
+  
+  int64_t Raw() const { return raw; }
+  
+  explicit operator double() const { return static_cast<double>(raw) / kOne; }
+  
+  FixedPoint operator-() const { return Saturate(-static_cast<__int128>(raw)); }
+  
+  FixedPoint operator+(FixedPoint other) const { return Saturate(static_cast<__int128>(raw) + other.raw); }
+  
+  FixedPoint operator-(FixedPoint other) const { return Saturate(static_cast<__int128>(raw) - other.raw); }
+  
+  FixedPoint operator*(FixedPoint other) const {
+    return Saturate((static_cast<__int128>(raw) * other.raw) >> FractionBits);
+  }
+  
+  // Division by zero saturates towards the sign of the dividend
+  FixedPoint operator/(FixedPoint other) const {
+    if (other.raw == 0) {
+      return FromRaw(raw < 0 ? Min() : raw > 0 ? Max() : 0);
+    }
+    return Saturate((static_cast<__int128>(raw) << FractionBits) / other.raw);
+  }
+  
+  FixedPoint &operator+=(FixedPoint other) { return *this = *this + other; }
+  
+  FixedPoint &operator-=(FixedPoint other) { return *this = *this - other; }
+  
+  FixedPoint &operator*=(FixedPoint other) { return *this = *this * other; }
+  
+  FixedPoint &operator/=(FixedPoint other) { return *this = *this / other; }
+  
+  bool operator==(FixedPoint other) const { return raw == other.raw; }
+  bool operator!=(FixedPoint other) const { return raw != other.raw; }
+  bool operator<(FixedPoint other) const { return raw < other.raw; }
+  bool operator>(FixedPoint other) const { return raw > other.raw; }
+  bool operator<=(FixedPoint other) const { return raw <= other.raw; }
+  bool operator>=(FixedPoint other) const { return raw >= other.raw; }
+  
+};
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,201 @@
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "FrameScanner.h"
+
+
+// Creates the frame from the bracket positions found by a scan
+static Frame MakeFrame(const char *first_bracket, const char *last_bracket) {
+  
+  Frame frame = {nullptr, 0};
+  
+  if (first_bracket != nullptr && last_bracket != nullptr && first_bracket < last_bracket) {
+    frame.payload = first_bracket;
+    frame.payload_length = last_bracket - first_bracket + 1;
+  }
+  
+  return frame;
+  
+}
+
+
+// True if "null" starts at c
+static bool IsNull(const char *c, const char *end) {
+  
+  return end - c >= 4 && memcmp(c, "null", 4) == 0;
+  
+}
+
+
+// Finds the last ']' of the frame, nullptr if there is none
+// The closing bracket is normally the last byte, so the backward search stops at once
+static const char *FindLastBracket(const char *data, const char *end) {
+  
+  for (const char *c = end; c != data; ) {
+    if (*--c == ']') {
+      return c;
+    }
+  }
+  
+  return nullptr;
+  
+}
+
+
+// Portable implementation
+// Skips to each candidate byte with memchr, which the C library vectorizes on most targets,
+// instead of testing every byte
+Frame ScanFrameScalar(const char *data, size_t length) {
+  
+  const char *end = data + length;
+  const char *c = data;
+  
+  // Checking each 'n' for the start of "null"
+  while ((c = static_cast<const char *>(memchr(c, 'n', end - c))) != nullptr) {
+    
+    if (IsNull(c, end)) {
+      return MakeFrame(nullptr, nullptr);
+    }
+    
+    ++c;
+    
+  }
+  
+  return MakeFrame(static_cast<const char *>(memchr(data, '[', length)), FindLastBracket(data, end));
+  
+}
+
+
+#if defined(__x86_64__)
+
+// Each step loads one block and compares it with 'n' and, until the first one is found, '['.
+// Only the positions of 'n' are checked for the start of "null", with a scalar compare that
+// may read into the next block. The bytes after the last full block are checked one at a time,
+// and the closing bracket is found by the backward search of the portable implementation.
+
+
+// Checks the bytes after the last block and finds the closing bracket
+static Frame FinishScan(const char *data, const char *c, const char *end, const char *first_bracket) {
+  
+  for (; c != end; ++c) {
+    
+    if (*c == 'n' && IsNull(c, end)) {
+      return MakeFrame(nullptr, nullptr);
+    }
+    
+    if (*c == '[' && first_bracket == nullptr) {
+      first_bracket = c;
+    }
+    
+  }
+  
+  return MakeFrame(first_bracket, FindLastBracket(data, end));
+  
+}
+
+
+// 16 bytes per step implementation
+// SSE2 is part of the x86-64 baseline
+Frame ScanFrameSse2(const char *data, size_t length) {
+  
+  const char *c = data;
+  const char *end = data + length;
+  const char *first_bracket = nullptr;
+  
+  const __m128i open = _mm_set1_epi8('[');
+  const __m128i n = _mm_set1_epi8('n');
+  
+  while (end - c >= 16) {
+    
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c));
+    
+    for (uint32_t ns = _mm_movemask_epi8(_mm_cmpeq_epi8(block, n)); ns != 0; ns &= ns - 1) {
+      if (IsNull(c + __builtin_ctz(ns), end)) {
+        return MakeFrame(nullptr, nullptr);
+      }
+    }
+    
+    if (first_bracket == nullptr) {
+      
+      uint32_t opens = _mm_movemask_epi8(_mm_cmpeq_epi8(block, open));
+      
+      if (opens != 0) {
+        first_bracket = c + __builtin_ctz(opens);
+      }
+      
+    }
+    
+    c += 16;
+    
+  }
+  
+  return FinishScan(data, c, end, first_bracket);
+  
+}
+
+
+// 32 bytes per step implementation
+__attribute__((target("avx2")))
+Frame ScanFrameAvx2(const char *data, size_t length) {
+  
+  const char *c = data;
+  const char *end = data + length;
+  const char *first_bracket = nullptr;
+  
+  const __m256i open = _mm256_set1_epi8('[');
+  const __m256i n = _mm256_set1_epi8('n');
+  
+  while (end - c >= 32) {
+    
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c));
+    
+    for (uint32_t ns = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, n)); ns != 0; ns &= ns - 1) {
+      if (IsNull(c + __builtin_ctz(ns), end)) {
+        return MakeFrame(nullptr, nullptr);
+      }
+    }
+    
+    if (first_bracket == nullptr) {
+      
+      uint32_t opens = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, open));
+      
+      if (opens != 0) {
+        first_bracket = c + __builtin_ctz(opens);
+      }
+      
+    }
+    
+    c += 32;
+    
+  }
+  
+  return FinishScan(data, c, end, first_bracket);
+  
+}
+
+
+// Uses the widest vector instructions supported by the CPU
+Frame ScanFrame(const char *data, size_t length) {
+  
+  if (HasAvx2()) {
+    return ScanFrameAvx2(data, length);
+  }
+  
+  return ScanFrameSse2(data, length);
+  
+}
+
+#else
+
+// Uses the portable implementation on other architectures
+Frame ScanFrame(const char *data, size_t length) {
+  
+  return ScanFrameScalar(data, length);
+  
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FRAME_SCANNER_H
+#define FRAME_SCANNER_H
+
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+// Bounds of the JSON payload of a SocketIO event frame
+// The payload points into the frame buffer and is not copied
+struct Frame {
+  
+  const char *payload;
+  size_t payload_length;
+  
+};
+
+// Checks if the SocketIO event frame has JSON data.
+// If there is data the payload bounds will be set to the JSON array,
+// else the payload will be set to nullptr (manual mode).
+// Uses the widest vector instructions supported by the CPU.
+Frame ScanFrame(const char *data, size_t length);
+
+// Portable implementation used on other architectures
+Frame ScanFrameScalar(const char *data, size_t length);
+
+#if defined(__x86_64__)
+
+// 16 bytes per step implementation
+Frame ScanFrameSse2(const char *data, size_t length);
+
+// 32 bytes per step implementation
+// Only call this if HasAvx2() returns true
+Frame ScanFrameAvx2(const char *data, size_t length);
+
+#endif
+
+#endif // FRAME_SCANNER_H
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "CpuFeatures.h"
+#include "GainEvaluator.h"
+#include "Trace.h"
+
+
+// Converts MPH to meters per second
+static const double kMphToMetersPerSecond = 0.44704;
+
+
+// Default parameters matching the simulator car
+ReplayModel DefaultReplayModel() {
+  
+  ReplayModel model;
+  model.wheelbase = 2.67;
+  model.max_steering_angle = 25.0 * M_PI / 180.0;
+  
+  return model;
+  
+}
+
+
+// Loads a flight trace recorded with pid --trace
+bool LoadReplayTrace(const std::string &path, ReplayTrace &trace) {
+  
+  std::vector<TraceRecord> records;
+  
+  if (!ReadTrace(path, records) || records.empty()) {
+    return false;
+  }
+  
+  trace.cte.clear();
+  trace.speed.clear();
+  trace.steer.clear();
+  
+  const uint32_t session = records.front().session;
+  uint64_t last_timestamp = records.front().timestamp;
+  
+  for (const auto &record : records) {
+    
+    if (record.session != session) {
+      continue;
+    }
+    
+    trace.cte.push_back(record.cte);
+    trace.speed.push_back(record.speed);
+    trace.steer.push_back(record.steer);
+    last_timestamp = record.timestamp;
+    
+  }
+  
+  if (trace.cte.size() < 2) {
+    return false;
+  }
+  
+  trace.dt = (last_timestamp - records.front().timestamp) * 1e-9 / (trace.cte.size() - 1);
+  
+  return true;
+  
+}
+
+
+// Evaluates candidates [begin, end) one at a time
+void EvaluateCandidatesScalar(const ReplayTrace &trace, const CandidateGains &candidates,
+                              const ReplayModel &model, size_t begin, size_t end, double *mse) {
+  
+  const size_t length = trace.cte.size();
+  const double heading_gain = trace.dt * model.max_steering_angle / model.wheelbase;
+  
+  for (size_t k = begin; k < end; ++k) {
+    
+    // PID errors
+    double p_error = 0.0;
+    double i_error = 0.0;
+    double d_error = 0.0;
+    double cte_past = 0.0;
+    double sum_squared_error = 0.0;
+    
+    // Deviation from the recorded trajectory
+    double heading = 0.0;
+    double offset = 0.0;
+    
+    for (size_t t = 0; t < length; ++t) {
+      
+      double error = trace.cte[t] + offset;
+      
+      // Same updates as PID::UpdateError and PID::TotalError
+      p_error = error;
+      i_error += error;
+      d_error = error - cte_past;
+      cte_past = error;
+      sum_squared_error += error * error;
+      
+      double total = candidates.kp[k] * p_error + candidates.ki[k] * i_error + candidates.kd[k] * d_error;
+      
+      // Normalizing and clamping the steering value as the simulator does
+      double steer = std::min(1.0, std::max(-1.0, total / -model.max_steering_angle));
+      
+      // Advancing the linearized deviation model
+      double distance = trace.speed[t] * kMphToMetersPerSecond;
+      offset += distance * trace.dt * heading;
+      heading += distance * heading_gain * (steer - trace.steer[t]);
+      
+    }
+    
+    mse[k] = length == 0 ? 0.0 : sum_squared_error / length;
+    
+  }
+  
+}
+
+
+#if defined(__x86_64__)
+
+// Evaluates four candidates at a time
+// Returns the number of candidates evaluated
+__attribute__((target("avx2")))
+static size_t EvaluateCandidatesAvx2(const ReplayTrace &trace, const CandidateGains &candidates,
+                                     const ReplayModel &model, double *mse) {
+  
+  const size_t length = trace.cte.size();
+  const size_t count = candidates.Size();
+  
+  const __m256d dt = _mm256_set1_pd(trace.dt);
+  const __m256d heading_gain = _mm256_set1_pd(trace.dt * model.max_steering_angle / model.wheelbase);
+  const __m256d steer_scale = _mm256_set1_pd(-model.max_steering_angle);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d minus_one = _mm256_set1_pd(-1.0);
+  
+  size_t k = 0;
+  
+  for (; k + 4 <= count; k += 4) {
+    
+    const __m256d kp = _mm256_loadu_pd(&candidates.kp[k]);
+    const __m256d ki = _mm256_loadu_pd(&candidates.ki[k]);
+    const __m256d kd = _mm256_loadu_pd(&candidates.kd[k]);
+    
+    __m256d i_error = _mm256_setzero_pd();
+    __m256d cte_past = _mm256_setzero_pd();
+    __m256d sum_squared_error = _mm256_setzero_pd();
+    __m256d heading = _mm256_setzero_pd();
+    __m256d offset = _mm256_setzero_pd();
+    
+    for (size_t t = 0; t < length; ++t) {
+      
+      __m256d error = _mm256_add_pd(_mm256_set1_pd(trace.cte[t]), offset);
+      
+      i_error = _mm256_add_pd(i_error, error);
+      __m256d d_error = _mm256_sub_pd(error, cte_past);
+      cte_past = error;
+      sum_squared_error = _mm256_add_pd(sum_squared_error, _mm256_mul_pd(error, error));
+      
+      __m256d total = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(kp, error), _mm256_mul_pd(ki, i_error)),
+                                    _mm256_mul_pd(kd, d_error));
+      
+      __m256d steer = _mm256_min_pd(one, _mm256_max_pd(minus_one, _mm256_div_pd(total, steer_scale)));
+      
+      __m256d distance = _mm256_set1_pd(trace.speed[t] * kMphToMetersPerSecond);
+      offset = _mm256_add_pd(offset, _mm256_mul_pd(_mm256_mul_pd(distance, dt), heading));
+      heading = _mm256_add_pd(heading, _mm256_mul_pd(_mm256_mul_pd(distance, heading_gain),
+                                                     _mm256_sub_pd(steer, _mm256_set1_pd(trace.steer[t]))));
+      
+    }
+    
+    if (length == 0) {
+      _mm256_storeu_pd(mse + k, _mm256_setzero_pd());
+    }
+    
+    else {
+      _mm256_storeu_pd(mse + k, _mm256_div_pd(sum_squared_error, _mm256_set1_pd(static_cast<double>(length))));
+    }
+    
+  }
+  
+  return k;
+  
+}
+
+#endif
+
+
+// Replays the recorded trace through every candidate
+void EvaluateCandidates(const ReplayTrace &trace, const CandidateGains &candidates,
+                        const ReplayModel &model, double *mse) {
+  
+  size_t k = 0;
+  
+#if defined(__x86_64__)
+  if (HasAvx2()) {
+    k = EvaluateCandidatesAvx2(trace, candidates, model, mse);
+  }
+#endif
+  
+  EvaluateCandidatesScalar(trace, candidates, model, k, candidates.Size(), mse);
+  
+}
@@ -0,0 +1,80 @@
+#ifndef GAIN_EVALUATOR_H
+#define GAIN_EVALUATOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Recorded telemetry replayed by the evaluator
+// One entry per tick in each array
+struct ReplayTrace {
+  
+  // Cross track error
+  std::vector<double> cte;
+  
+  // Speed in MPH
+  std::vector<double> speed;
+  
+  // Normalized steering value that was sent during the recording
+  std::vector<double> steer;
+  
+  // Mean time between ticks in seconds
+  double dt;
+  
+};
+
+// Candidate gain sets stored as a structure of arrays
+struct CandidateGains {
+  
+  std::vector<double> kp;
+  std::vector<double> ki;
+  std::vector<double> kd;
+  
+  size_t Size() const { return kp.size(); }
+  
+  void Add(double Kp, double Ki, double Kd) {
+    kp.push_back(Kp);
+    ki.push_back(Ki);
+    kd.push_back(Kd);
+  }
+  
+};
+
+// Vehicle parameters of the replay model
+struct ReplayModel {
+  
+  // Distance between the axles in meters
+  double wheelbase;
+  
+  // Steering angle in radians for a normalized steering value of 1
+  double max_steering_angle;
+  
+};
+
+// Default parameters matching the simulator car
+ReplayModel DefaultReplayModel();
+
+// Loads a flight trace recorded with pid --trace
+// Only the ticks of the session of the first record are loaded, so that the ticks of
+// simulators driving at the same time are not interleaved
+// Returns false if the file cannot be read or the session has fewer than 2 ticks
+bool LoadReplayTrace(const std::string &path, ReplayTrace &trace);
+
+// Replays the recorded trace through every candidate and writes the accumulated
+// mean squared cross track error each one reaches, as PID::CalculateError computes it.
+//
+// Replaying recorded errors open loop would give every candidate the same error,
+// so the replay is closed around a linearized bicycle model: the recorded cte is
+// taken as the response to the recorded steering, and the difference between the
+// candidate's steering and the recorded steering moves the heading and lateral
+// offset that are added to it.
+//
+// Candidates are evaluated four at a time with AVX2 when the CPU supports it
+void EvaluateCandidates(const ReplayTrace &trace, const CandidateGains &candidates,
+                        const ReplayModel &model, double *mse);
+
+// Evaluates candidates [begin, end) one at a time, used for the remainder and as a reference
+void EvaluateCandidatesScalar(const ReplayTrace &trace, const CandidateGains &candidates,
+                              const ReplayModel &model, size_t begin, size_t end, double *mse);
+
+#endif // GAIN_EVALUATOR_H
@@ -0,0 +1,12 @@
+#ifndef JSON_H
+#define JSON_H
+
+// nlohmann::json, included through here so that the whole tree builds warning free
+// With optimization, GCC reports -Wmaybe-uninitialized false positives in the parser of
+// json.hpp; they are silenced for the library only and stay enabled for the rest of the code
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include "json.hpp"
+#pragma GCC diagnostic pop
+
+#endif // JSON_H
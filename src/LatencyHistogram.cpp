@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstring>
+
+#include "LatencyHistogram.h"
+
+
+// Empty snapshot
+HistogramSnapshot::HistogramSnapshot() : total(0), sum(0) {
+  
+  memset(counts, 0, sizeof(counts));
+  
+}
+
+
+// Adds the counts of another snapshot
+void HistogramSnapshot::Add(const HistogramSnapshot &other) {
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    counts[k] += other.counts[k];
+  }
+  
+  total += other.total;
+  sum += other.sum;
+  
+}
+
+
+// Counts recorded since an earlier snapshot of the same histogram
+HistogramSnapshot HistogramSnapshot::Since(const HistogramSnapshot &earlier) const {
+  
+  HistogramSnapshot interval;
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    interval.counts[k] = counts[k] - earlier.counts[k];
+  }
+  
+  interval.total = total - earlier.total;
+  interval.sum = sum - earlier.sum;
+  
+  return interval;
+  
+}
+
+
+// Value at or below which the given fraction of the recorded values lie
+uint64_t HistogramSnapshot::Percentile(double fraction) const {
+  
+  if (total == 0) {
+    return 0;
+  }
+  
+  // Rank of the value, counted from 1
+  uint64_t rank = uint64_t(fraction * total + 0.5);
+  
+  if (rank < 1) {
+    rank = 1;
+  }
+  
+  uint64_t seen = 0;
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    
+    seen += counts[k];
+    
+    if (seen >= rank) {
+      return LatencyHistogram::BucketUpperBound(k);
+    }
+    
+  }
+  
+  return Max();
+  
+}
+
+
+// Percentiles of several fractions, given in increasing order, in one pass over the buckets
+void HistogramSnapshot::Percentiles(const double *fractions, size_t count, uint64_t *values) const {
+  
+  size_t found = 0;
+  uint64_t seen = 0;
+  
+  for (size_t k = 0; k < kHistogramBuckets && found < count; ++k) {
+    
+    seen += counts[k];
+    
+    // Ranks counted from 1, as in Percentile
+    while (found < count && seen >= std::max<uint64_t>(uint64_t(fractions[found] * total + 0.5), 1)) {
+      values[found++] = LatencyHistogram::BucketUpperBound(k);
+    }
+    
+  }
+  
+  // Empty snapshots and fractions above 1
+  for (; found < count; ++found) {
+    values[found] = Max();
+  }
+  
+}
+
+
+// Upper bound of the bucket holding the largest recorded value
+uint64_t HistogramSnapshot::Max() const {
+  
+  for (size_t k = kHistogramBuckets; k > 0; --k) {
+    if (counts[k - 1] != 0) {
+      return LatencyHistogram::BucketUpperBound(k - 1);
+    }
+  }
+  
+  return 0;
+  
+}
+
+
+// Constructor
+LatencyHistogram::LatencyHistogram() {
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    counts[k].store(0, std::memory_order_relaxed);
+  }
+  
+  sum.store(0, std::memory_order_relaxed);
+  
+}
+
+
+// Copies the counts and the sum
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+  
+  HistogramSnapshot snapshot;
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    snapshot.counts[k] = counts[k].load(std::memory_order_relaxed);
+    snapshot.total += snapshot.counts[k];
+  }
+  
+  snapshot.sum = sum.load(std::memory_order_relaxed);
+  
+  return snapshot;
+  
+}
+
+
+// Adds the counts and the sum to a snapshot
+void LatencyHistogram::AddTo(HistogramSnapshot &snapshot) const {
+  
+  for (size_t k = 0; k < kHistogramBuckets; ++k) {
+    uint64_t count = counts[k].load(std::memory_order_relaxed);
+    snapshot.counts[k] += count;
+    snapshot.total += count;
+  }
+  
+  snapshot.sum += sum.load(std::memory_order_relaxed);
+  
+}
+
+
+// Largest value of a bucket
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  
+  if (index < 2 * kSubBuckets) {
+    return index;
+  }
+  
+  // Inverting BucketIndex, the bucket holds the values whose top bits are index % kSubBuckets + kSubBuckets
+  size_t shift = index / kSubBuckets - 1;
+  uint64_t top = index % kSubBuckets + kSubBuckets;
+  
+  return ((top + 1) << shift) - 1;
+  
+}
@@ -0,0 +1,98 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Precision of the histograms, each power of two range is split into 2^kSubBucketBits buckets
+// Recorded values are reported with a relative error below 1 / 2^kSubBucketBits, about 3%
+const int kSubBucketBits = 5;
+const size_t kSubBuckets = size_t(1) << kSubBucketBits;
+
+// Buckets covering every 64 bit value
+const size_t kHistogramBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+// Copy of the counts of a LatencyHistogram at one point in time
+struct HistogramSnapshot {
+  
+  uint64_t counts[kHistogramBuckets];
+  uint64_t total;
+  
+  // Sum of the recorded values, exact rather than bucketed
+  uint64_t sum;
+  
+  // Empty snapshot
+  HistogramSnapshot();
+  
+  // Adds the counts of another snapshot, for merging histograms
+  void Add(const HistogramSnapshot &other);
+  
+  // Counts recorded since an earlier snapshot of the same histogram
+  HistogramSnapshot Since(const HistogramSnapshot &earlier) const;
+  
+  // Value at or below which the given fraction of the recorded values lie, 0.5 for the median
+  // Returns the upper bound of the bucket holding that value, or 0 if the snapshot is empty
+  uint64_t Percentile(double fraction) const;
+  
+  // Percentiles of several fractions, given in increasing order, in one pass over the buckets
+  void Percentiles(const double *fractions, size_t count, uint64_t *values) const;
+  
+  // Upper bound of the bucket holding the largest recorded value, or 0 if the snapshot is empty
+  uint64_t Max() const;
+  
+};
+
+// Log-linear histogram of durations in nanoseconds, after HdrHistogram
+// Values below kSubBuckets get a bucket each; above, each power of two range is split
+// into kSubBuckets equal buckets. Recording is two relaxed atomic additions, to the bucket and
+// to the sum, so any number of threads may record while others take snapshots, and nothing
+// ever blocks.
+class LatencyHistogram {
+  
+private:
+  
+  std::atomic<uint64_t> counts[kHistogramBuckets];
+  std::atomic<uint64_t> sum;
+  
+public:
+  
+  // Constructor
+  LatencyHistogram();
+  
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+  
+  // Records one value
+  void Record(uint64_t value) {
+    counts[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+  }
+  
+  // Copies the counts and the sum
+  // Values recorded during the copy may or may not be included, in the counts and the sum alike
+  HistogramSnapshot Snapshot() const;
+  
+  // Adds the counts and the sum to a snapshot, merging histograms without copying each of them first
+  void AddTo(HistogramSnapshot &snapshot) const;
+  
+  // Bucket of a value
+  static size_t BucketIndex(uint64_t value) {
+    
+    if (value < kSubBuckets) {
+      return size_t(value);
+    }
+    
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - kSubBucketBits;
+    
+    return size_t(shift) * kSubBuckets + size_t(value >> shift);
+    
+  }
+  
+  // Largest value of a bucket
+  static uint64_t BucketUpperBound(size_t index);
+  
+};
+
+#endif // LATENCY_HISTOGRAM_H
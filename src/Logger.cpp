@@ -0,0 +1,265 @@
+#include <chrono>
+#include <cstdio>
+
+#include "Logger.h"
+#include "StageTimer.h"
+
+
+// The process wide logger
+Logger &Logger::Instance() {
+  
+  static Logger logger;
+  return logger;
+  
+}
+
+
+Logger::Logger() : write_position(0), read_position(0), dropped(0), running(false) {
+  
+  for (size_t n = 0; n < kCapacity; ++n) {
+    slots[n].sequence.store(n, std::memory_order_relaxed);
+  }
+  
+}
+
+
+Logger::~Logger() {
+  
+  Stop();
+  
+}
+
+
+// Starts the background writer thread
+void Logger::Start() {
+  
+  if (!running.exchange(true)) {
+    writer = std::thread(&Logger::Run, this);
+  }
+  
+}
+
+
+// Writes the remaining records and stops the background writer thread
+void Logger::Stop() {
+  
+  if (running.exchange(false)) {
+    writer.join();
+  }
+  
+}
+
+
+// Adds a record to the ring buffer without blocking
+void Logger::Write(int level, LogEvent event, double v0, double v1, double v2) {
+  
+  size_t position = write_position.load(std::memory_order_relaxed);
+  Slot *slot;
+  
+  // Claiming a slot, retrying if another producer claimed it first
+  for (;;) {
+    
+    slot = &slots[position & (kCapacity - 1)];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    
+    if (difference == 0) {
+      if (write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    
+    // The consumer has not freed this slot yet, the ring buffer is full
+    else if (difference < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    
+    else {
+      position = write_position.load(std::memory_order_relaxed);
+    }
+    
+  }
+  
+  slot->record.event = event;
+  slot->record.level = static_cast<uint8_t>(level);
+  slot->record.values[0] = v0;
+  slot->record.values[1] = v1;
+  slot->record.values[2] = v2;
+  
+  // Publishing the record to the consumer
+  slot->sequence.store(position + 1, std::memory_order_release);
+  
+}
+
+
+// Takes the oldest record from the ring buffer
+bool Logger::Pop(LogRecord &record) {
+  
+  size_t position = read_position.load(std::memory_order_relaxed);
+  Slot &slot = slots[position & (kCapacity - 1)];
+  
+  if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+    return false;
+  }
+  
+  record = slot.record;
+  
+  // Handing the slot back to the producers
+  slot.sequence.store(position + kCapacity, std::memory_order_release);
+  read_position.store(position + 1, std::memory_order_relaxed);
+  
+  return true;
+  
+}
+
+
+// Number of records dropped so far
+uint64_t Logger::Dropped() const {
+  
+  return dropped.load(std::memory_order_relaxed);
+  
+}
+
+
+// Formats and flushes records until the logger is stopped
+void Logger::Run() {
+  
+  LogRecord record;
+  uint64_t reported_dropped = 0;
+  
+  for (;;) {
+    
+    // Checking before draining so that records written before Stop() are not lost
+    bool stopping = !running.load(std::memory_order_acquire);
+    bool wrote = false;
+    
+    while (Pop(record)) {
+      Format(record);
+      wrote = true;
+    }
+    
+    uint64_t total_dropped = Dropped();
+    
+    if (total_dropped != reported_dropped) {
+      fprintf(stdout, "Log records dropped: %llu\n", static_cast<unsigned long long>(total_dropped - reported_dropped));
+      reported_dropped = total_dropped;
+      wrote = true;
+    }
+    
+    // One flush per batch instead of one per line
+    if (wrote) {
+      fflush(stdout);
+    }
+    
+    if (stopping) {
+      break;
+    }
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    
+  }
+  
+}
+
+
+// Writes one record as text
+void Logger::Format(const LogRecord &record) {
+  
+  static const char *kGainNames[] = {"Proportional", "Integral", "Derivative"};
+  
+  const double *v = record.values;
+  
+  switch (record.event) {
+      
+    case LogEvent::kListening: {
+      fprintf(stdout, "Listening to port %d\n", static_cast<int>(v[0]));
+      break;
+    }
+      
+    case LogEvent::kConnected: {
+      fprintf(stdout, "Connected!!! Session %ld, %ld open\n", static_cast<long>(v[0]), static_cast<long>(v[1]));
+      break;
+    }
+      
+    case LogEvent::kDisconnected: {
+      fprintf(stdout, "Disconnected Session %ld, %ld open\n", static_cast<long>(v[0]), static_cast<long>(v[1]));
+      break;
+    }
+      
+    case LogEvent::kOptimizing: {
+      fputs("Optimizing\n", stdout);
+      break;
+    }
+      
+    case LogEvent::kOptimized: {
+      fputs("Optimized\n", stdout);
+      break;
+    }
+      
+    case LogEvent::kResetting: {
+      fputs("Resetting\n", stdout);
+      break;
+    }
+      
+    case LogEvent::kTwiddling: {
+      fputs("Twiddling\n", stdout);
+      break;
+    }
+      
+    case LogEvent::kErrors: {
+      fprintf(stdout, "Best Error: %g Current Error: %g\n", v[0], v[1]);
+      break;
+    }
+      
+    case LogEvent::kTuning: {
+      
+      int i = static_cast<int>(v[0]);
+      
+      if (i >= 0 && i < 3) {
+        fprintf(stdout, "Tuning %s Gain - Twiddle Order: %d\n", kGainNames[i], static_cast<int>(v[1]));
+      }
+      
+      break;
+      
+    }
+      
+    case LogEvent::kGainIncrements: {
+      fprintf(stdout, "P inc: %g I inc: %g D inc: %g\n", v[0], v[1], v[2]);
+      break;
+    }
+      
+    case LogEvent::kGains: {
+      fprintf(stdout, "P: %g I: %g D: %g\n", v[0], v[1], v[2]);
+      break;
+    }
+      
+    case LogEvent::kControl: {
+      fprintf(stdout, "CTE: %g Steering Value: %g degrees\nThrottle Value: %g\n\n", v[0], v[1], v[2]);
+      break;
+    }
+      
+    case LogEvent::kPipeline: {
+      fprintf(stdout, "Pipeline frames: %ld Dropped: %ld Stale: %ld\n",
+              static_cast<long>(v[0]), static_cast<long>(v[1]), static_cast<long>(v[2]));
+      break;
+    }
+      
+    case LogEvent::kCoalesced: {
+      fprintf(stdout, "Pipeline coalesced frames: %ld\n", static_cast<long>(v[0]));
+      break;
+    }
+      
+    case LogEvent::kLatency: {
+      fprintf(stdout, "Latency %s p50: %.0f ns p99: %.0f ns\n", StageName(static_cast<int>(v[0])), v[1], v[2]);
+      break;
+    }
+      
+    case LogEvent::kLatencyTail: {
+      fprintf(stdout, "Latency %s p99.9: %.0f ns max: %.0f ns\n", StageName(static_cast<int>(v[0])), v[1], v[2]);
+      break;
+    }
+      
+  } // End switch
+  
+}
@@ -0,0 +1,136 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Log levels
+// Levels below LOG_LEVEL are removed at compile time
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Events written to the log
+// The background thread turns each event and its values into text
+enum class LogEvent : uint8_t {
+  kListening,        // port
+  kConnected,        // session id, open sessions
+  kDisconnected,     // session id, open sessions
+  kOptimizing,
+  kOptimized,
+  kResetting,
+  kTwiddling,
+  kErrors,           // best error, current error
+  kTuning,           // gain index, twiddle order
+  kGainIncrements,   // P, I and D increments
+  kGains,            // P, I and D gains
+  kControl,          // cte, steering value in degrees, throttle value
+  kPipeline,         // frames submitted, dropped and stale
+  kCoalesced,        // stale frames answered by a newer frame's command
+  kLatency,          // stage, median and 99th percentile in nanoseconds
+  kLatencyTail       // stage, 99.9th percentile and maximum in nanoseconds
+};
+
+// Fixed-size binary log record
+struct LogRecord {
+  
+  LogEvent event;
+  uint8_t level;
+  double values[3];
+  
+};
+
+class Logger {
+  
+private:
+  
+  // Number of records the ring buffer holds, a power of two
+  static const size_t kCapacity = 4096;
+  
+  // Ring buffer slot
+  // The sequence number tells producers and the consumer whose turn it is
+  struct Slot {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+  };
+  
+  Slot slots[kCapacity];
+  
+  // Producer and consumer positions on separate cache lines
+  alignas(64) std::atomic<size_t> write_position;
+  alignas(64) std::atomic<size_t> read_position;
+  
+  // Records dropped because the ring buffer was full
+  alignas(64) std::atomic<uint64_t> dropped;
+  
+  std::atomic<bool> running;
+  std::thread writer;
+  
+  // Formats and flushes records until the logger is stopped
+  void Run();
+  
+  // Takes the oldest record from the ring buffer
+  bool Pop(LogRecord &record);
+  
+  // Writes one record as text
+  static void Format(const LogRecord &record);
+  
+  Logger();
+  
+public:
+  
+  // The process wide logger
+  static Logger &Instance();
+  
+  ~Logger();
+  
+  // Starts the background writer thread
+  void Start();
+  
+  // Writes the remaining records and stops the background writer thread
+  void Stop();
+  
+  // Adds a record to the ring buffer without blocking
+  // The record is dropped if the ring buffer is full
+  void Write(int level, LogEvent event, double v0 = 0.0, double v1 = 0.0, double v2 = 0.0);
+  
+  // Number of records dropped so far
+  uint64_t Dropped() const;
+  
+};
+
+// Logging macros
+// Disabled levels expand to nothing so their arguments are never evaluated
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Logger::Instance().Write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Logger::Instance().Write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) Logger::Instance().Write(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Logger::Instance().Write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void) 0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,115 @@
+#include <string>
+
+#include "Json.h"
+#include "FrameScanner.h"
+#include "MessageHandler.h"
+#include "Metrics.h"
+
+using json = nlohmann::json;
+
+
+// Constructor
+MessageHandler::MessageHandler(TraceWriter &trace) : trace(trace) {}
+
+
+// Checks the SocketIO framing of a message and reads its telemetry
+MessageKind MessageHandler::Read(const char *data, size_t length, Telemetry &telemetry, StageTimer &timer) const {
+  
+  // "42" at the start of the message means there's a websocket message event.
+  // The 4 signifies a websocket message
+  // The 2 signifies a websocket event
+  if (!(length > 2 && data[0] == '4' && data[1] == '2')) {
+    return MessageKind::kIgnored;
+  }
+  
+  // The payload is read in place from the message buffer
+  Frame frame = ScanFrame(data, length);
+  
+  timer.Lap(kStageFrameScan);
+  
+  if (frame.payload == nullptr) {
+    return MessageKind::kManual;
+  }
+  
+  bool is_telemetry = ParseTelemetry(frame.payload, frame.payload_length, telemetry);
+  
+  // Falling back to the JSON parser for other events and unexpected layouts
+  if (!is_telemetry) {
+    
+    auto j = json::parse(frame.payload, frame.payload + frame.payload_length);
+    std::string event = j[0].get<std::string>();
+    
+    if (event == "telemetry") {
+      
+      // j[1] is the data JSON object
+      telemetry.cte = std::stod(j[1]["cte"].get<std::string>());
+      telemetry.speed = std::stod(j[1]["speed"].get<std::string>());
+      telemetry.steering_angle = std::stod(j[1]["steering_angle"].get<std::string>());
+      is_telemetry = true;
+      
+    }
+    
+  }
+  
+  timer.Lap(kStageParse);
+  
+  return is_telemetry ? MessageKind::kTelemetry : MessageKind::kIgnored;
+  
+}
+
+
+// Runs the session's controller for one telemetry tick, then traces it and publishes its metrics
+ControlCommand MessageHandler::Control(Session &session, const Telemetry &telemetry, StageTimer &timer) {
+  
+  ControlCommand command = session.controller.Step(telemetry, timer);
+  
+  TraceTick(trace, session.id, session.controller.pid_steering, telemetry, command);
+  PublishTick(session.metrics, session.controller, command);
+  timer.Lap(kStageLogging);
+  
+  return command;
+  
+}
+
+
+// Turns a command into its reply
+void MessageHandler::Serialize(const ControlCommand &command, Reply &reply, StageTimer &timer) {
+  
+  if (command.action == ControlAction::kReset) {
+    reply.kind = ReplyKind::kReset;
+    reply.length = 0;
+  }
+  
+  else {
+    reply.kind = ReplyKind::kSteer;
+    reply.length = WriteSteerCommand(reply.msg, command.steering_angle, command.throttle);
+    timer.Lap(kStageSerialization);
+  }
+  
+}
+
+
+// Reads a message, runs the controller for telemetry and writes the reply
+void MessageHandler::Handle(Session &session, const char *data, size_t length, Reply &reply, StageTimer &timer) {
+  
+  Telemetry telemetry;
+  
+  switch (Read(data, length, telemetry, timer)) {
+    
+    case MessageKind::kTelemetry:
+      Serialize(Control(session, telemetry, timer), reply, timer);
+      break;
+    
+    case MessageKind::kManual:
+      reply.kind = ReplyKind::kManual;
+      reply.length = 0;
+      break;
+    
+    case MessageKind::kIgnored:
+      reply.kind = ReplyKind::kNone;
+      reply.length = 0;
+      break;
+    
+  }
+  
+}
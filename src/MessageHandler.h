@@ -0,0 +1,70 @@
+#ifndef MESSAGE_HANDLER_H
+#define MESSAGE_HANDLER_H
+
+#include <cstddef>
+
+#include "Commands.h"
+#include "Controller.h"
+#include "Session.h"
+#include "StageTimer.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+// Kind of message received from the simulator
+enum class MessageKind {
+  kIgnored,    // not a SocketIO event, or an event other than telemetry
+  kTelemetry,  // telemetry in autonomous mode
+  kManual      // event without data, the simulator is in manual mode
+};
+
+// Message sent back to the simulator
+enum class ReplyKind {
+  kNone,       // nothing to send
+  kSteer,      // steer command written to the reply buffer
+  kReset,      // constant reset event
+  kManual      // constant manual event
+};
+
+// Reply to one message
+// Constant events are framed once by the server, so only steer commands carry text
+struct Reply {
+  
+  ReplyKind kind;
+  
+  // Steer command, set for kSteer
+  char msg[kMaxSteerCommandLength];
+  size_t length;
+  
+};
+
+// Handles the messages of simulator sessions without any socket
+// Turns a received frame into the reply to send, so the same code runs in the server
+// and in benchmarks
+class MessageHandler {
+  
+private:
+  
+  // Flight trace of the sessions, may be closed
+  TraceWriter &trace;
+  
+public:
+  
+  // Constructor
+  explicit MessageHandler(TraceWriter &trace);
+  
+  // Checks the SocketIO framing of a message and reads its telemetry
+  // The telemetry is only set for kTelemetry
+  MessageKind Read(const char *data, size_t length, Telemetry &telemetry, StageTimer &timer) const;
+  
+  // Runs the session's controller for one telemetry tick, then traces it and publishes its metrics
+  ControlCommand Control(Session &session, const Telemetry &telemetry, StageTimer &timer);
+  
+  // Turns a command into its reply
+  static void Serialize(const ControlCommand &command, Reply &reply, StageTimer &timer);
+  
+  // Reads a message, runs the controller for telemetry and writes the reply
+  void Handle(Session &session, const char *data, size_t length, Reply &reply, StageTimer &timer);
+  
+};
+
+#endif // MESSAGE_HANDLER_H
@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "Logger.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+
+// Quantiles rendered for each stage
+static const double kQuantiles[] = {0.5, 0.99, 0.999};
+
+
+// Appends a formatted line to out
+template <typename... Args>
+static void Append(std::string &out, const char *format, Args... args) {
+  
+  char line[256];
+  int length = snprintf(line, sizeof(line), format, args...);
+  
+  if (length > 0) {
+    out.append(line, std::min(size_t(length), sizeof(line) - 1));
+  }
+  
+}
+
+
+// Appends the HELP and TYPE lines of a metric
+static void Describe(std::string &out, const char *name, const char *type, const char *help) {
+  
+  Append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  
+}
+
+
+// Adds one to a counter written by a single thread
+static void Increment(std::atomic<long> &counter) {
+  
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  
+}
+
+
+// Constructor
+MetricsRegistry::MetricsRegistry() : sessions_opened(0), sessions_open(0), histograms(nullptr), pipelines(nullptr) {
+  
+  for (SessionMetrics &slot : sessions) {
+    slot.session.store(0, std::memory_order_relaxed);
+    slot.ticks.store(0, std::memory_order_relaxed);
+    slot.resets.store(0, std::memory_order_relaxed);
+    slot.twiddles.store(0, std::memory_order_relaxed);
+  }
+  
+}
+
+
+// Adds the stage histograms and pipeline counters of the event loops to the metrics
+void MetricsRegistry::Attach(const std::vector<StageHistograms> *histograms,
+                             const std::vector<PipelineCounters> *pipelines) {
+  
+  this->histograms = histograms;
+  this->pipelines = pipelines;
+  
+}
+
+
+// Counts a new session and returns its id
+long MetricsRegistry::OpenSession() {
+  
+  sessions_open.fetch_add(1, std::memory_order_relaxed);
+  
+  return sessions_opened.fetch_add(1, std::memory_order_relaxed) + 1;
+  
+}
+
+
+// Counts a closed session and returns the number of sessions still open
+long MetricsRegistry::CloseSession() {
+  
+  return sessions_open.fetch_sub(1, std::memory_order_relaxed) - 1;
+  
+}
+
+
+// Number of sessions open
+long MetricsRegistry::SessionsOpen() const {
+  
+  return sessions_open.load(std::memory_order_relaxed);
+  
+}
+
+
+// Claims a slot for the session
+SessionMetrics *MetricsRegistry::Acquire(long session) {
+  
+  for (SessionMetrics &slot : sessions) {
+    
+    long expected = 0;
+    
+    if (!slot.session.compare_exchange_strong(expected, -1, std::memory_order_acquire)) {
+      continue;
+    }
+    
+    // Starting the session's counts from the slot's totals
+    slot.base_ticks.store(slot.ticks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot.base_resets.store(slot.resets.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot.base_twiddles.store(slot.twiddles.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    
+    slot.best_error.store(0.0, std::memory_order_relaxed);
+    slot.error.store(0.0, std::memory_order_relaxed);
+    slot.gains[0].store(0.0, std::memory_order_relaxed);
+    slot.gains[1].store(0.0, std::memory_order_relaxed);
+    slot.gains[2].store(0.0, std::memory_order_relaxed);
+    slot.increments.store(0.0, std::memory_order_relaxed);
+    slot.index.store(0, std::memory_order_relaxed);
+    slot.order.store(0, std::memory_order_relaxed);
+    
+    slot.session.store(session, std::memory_order_release);
+    
+    return &slot;
+    
+  }
+  
+  return nullptr;
+  
+}
+
+
+// Frees a slot
+void MetricsRegistry::Release(SessionMetrics *metrics) {
+  
+  if (metrics != nullptr) {
+    metrics->session.store(0, std::memory_order_release);
+  }
+  
+}
+
+
+// Publishes the state of the controller after a tick
+void PublishTick(SessionMetrics *metrics, const Controller &controller, const ControlCommand &command) {
+  
+  if (metrics == nullptr) {
+    return;
+  }
+  
+  const PDController &pid = controller.pid_steering;
+  
+  Increment(metrics->ticks);
+  
+  if (command.trace_flags & kTraceReset) {
+    Increment(metrics->resets);
+  }
+  
+  if (command.trace_flags & kTraceTwiddle) {
+    Increment(metrics->twiddles);
+  }
+  
+  metrics->best_error.store(pid.best_error, std::memory_order_relaxed);
+  metrics->error.store(pid.iterations == 0 ? 0.0 : pid.sum_squared_error / pid.iterations, std::memory_order_relaxed);
+  metrics->gains[0].store(pid.gains[0], std::memory_order_relaxed);
+  metrics->gains[1].store(pid.gains[1], std::memory_order_relaxed);
+  metrics->gains[2].store(pid.gains[2], std::memory_order_relaxed);
+  metrics->increments.store(pid.gain_increments[0] + pid.gain_increments[1] + pid.gain_increments[2],
+                            std::memory_order_relaxed);
+  metrics->index.store(pid.i, std::memory_order_relaxed);
+  metrics->order.store(pid.order, std::memory_order_relaxed);
+  
+}
+
+
+// Appends the metrics to out in the Prometheus text format
+void MetricsRegistry::Render(std::string &out) const {
+  
+  // Totals over every slot, including the sessions that have closed
+  long ticks = 0;
+  long resets = 0;
+  long twiddles = 0;
+  
+  for (const SessionMetrics &slot : sessions) {
+    ticks += slot.ticks.load(std::memory_order_relaxed);
+    resets += slot.resets.load(std::memory_order_relaxed);
+    twiddles += slot.twiddles.load(std::memory_order_relaxed);
+  }
+  
+  Describe(out, "pid_sessions_open", "gauge", "Connected simulators.");
+  Append(out, "pid_sessions_open %ld\n", sessions_open.load(std::memory_order_relaxed));
+  
+  Describe(out, "pid_sessions_opened_total", "counter", "Simulator connections accepted.");
+  Append(out, "pid_sessions_opened_total %ld\n", sessions_opened.load(std::memory_order_relaxed));
+  
+  Describe(out, "pid_ticks_total", "counter", "Telemetry ticks answered by the controllers.");
+  Append(out, "pid_ticks_total %ld\n", ticks);
+  
+  Describe(out, "pid_resets_total", "counter", "Simulator resets requested while tuning.");
+  Append(out, "pid_resets_total %ld\n", resets);
+  
+  Describe(out, "pid_twiddles_total", "counter", "Twiddle steps taken.");
+  Append(out, "pid_twiddles_total %ld\n", twiddles);
+  
+  Describe(out, "pid_log_records_dropped_total", "counter", "Log records dropped because the log ring was full.");
+  Append(out, "pid_log_records_dropped_total %llu\n",
+         static_cast<unsigned long long>(Logger::Instance().Dropped()));
+  
+  // Pipeline counters of each event loop
+  if (pipelines != nullptr && !pipelines->empty()) {
+    
+    static const char *const kNames[] = {
+      "pid_pipeline_frames_total", "pid_pipeline_dropped_total",
+      "pid_pipeline_stale_total", "pid_pipeline_coalesced_total"
+    };
+    
+    static const char *const kHelp[] = {
+      "Frames handed to the control thread.", "Frames dropped because the pipeline ring was full.",
+      "Frames superseded by a newer frame of their session.", "Stale frames answered by a newer frame's command."
+    };
+    
+    for (int counter = 0; counter < 4; ++counter) {
+      
+      Describe(out, kNames[counter], "counter", kHelp[counter]);
+      
+      for (size_t loop = 0; loop < pipelines->size(); ++loop) {
+        
+        const PipelineCounters &counters = (*pipelines)[loop];
+        const std::atomic<long> *values[] = {&counters.submitted, &counters.dropped, &counters.stale, &counters.coalesced};
+        
+        Append(out, "%s{loop=\"%zu\"} %ld\n", kNames[counter], loop, values[counter]->load(std::memory_order_relaxed));
+        
+      }
+      
+    }
+    
+  }
+  
+  // Stage latencies since the start, merged over the event loops
+  // The histograms of a stage are added straight into one snapshot, whose quantiles take one pass
+  if (histograms != nullptr && !histograms->empty()) {
+    
+    const size_t quantiles = sizeof(kQuantiles) / sizeof(kQuantiles[0]);
+    
+    uint64_t maxima[kStageCount];
+    
+    Describe(out, "pid_stage_latency_seconds", "summary", "Time spent in each stage of a tick, sampled one tick in 16.");
+    
+    for (int stage = 0; stage < kStageCount; ++stage) {
+      
+      HistogramSnapshot total;
+      
+      for (const StageHistograms &loop : *histograms) {
+        loop.stages[stage].AddTo(total);
+      }
+      
+      uint64_t values[quantiles];
+      total.Percentiles(kQuantiles, quantiles, values);
+      maxima[stage] = total.Max();
+      
+      for (size_t quantile = 0; quantile < quantiles; ++quantile) {
+        Append(out, "pid_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+               StageName(stage), kQuantiles[quantile], values[quantile] * 1e-9);
+      }
+      
+      Append(out, "pid_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n", StageName(stage), total.sum * 1e-9);
+      Append(out, "pid_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+             StageName(stage), static_cast<unsigned long long>(total.total));
+      
+    }
+    
+    Describe(out, "pid_stage_latency_max_seconds", "gauge", "Longest time spent in each stage of a tick.");
+    
+    for (int stage = 0; stage < kStageCount; ++stage) {
+      Append(out, "pid_stage_latency_max_seconds{stage=\"%s\"} %.9f\n", StageName(stage), maxima[stage] * 1e-9);
+    }
+    
+  }
+  
+  // Counters and twiddle progress of the open sessions
+  static const char *const kSessionNames[] = {
+    "pid_session_ticks_total", "pid_session_resets_total", "pid_session_twiddles_total",
+    "pid_session_best_error", "pid_session_error", "pid_session_gain", "pid_session_gain_increments",
+    "pid_session_twiddle_index", "pid_session_twiddle_order"
+  };
+  
+  static const char *const kSessionTypes[] = {
+    "counter", "counter", "counter", "gauge", "gauge", "gauge", "gauge", "gauge", "gauge"
+  };
+  
+  // Taking the threshold from the controller, so the help text follows it
+  char increments_help[96];
+  snprintf(increments_help, sizeof(increments_help),
+           "Sum of the steering gain increments, tuning stops once it falls to %g.", kTuningThreshold);
+  
+  const char *const session_help[] = {
+    "Telemetry ticks answered for the session.", "Resets requested for the session.",
+    "Twiddle steps taken for the session.", "Best accumulated mean squared cross track error.",
+    "Accumulated mean squared cross track error of the current twiddle step.",
+    "Steering gain by term.", increments_help,
+    "Index of the steering gain being tuned.", "Twiddle order of the gain being tuned."
+  };
+  
+  static const char *const kTerms[] = {"p", "i", "d"};
+  
+  for (int metric = 0; metric < 9; ++metric) {
+    
+    Describe(out, kSessionNames[metric], kSessionTypes[metric], session_help[metric]);
+    
+    for (const SessionMetrics &slot : sessions) {
+      
+      long session = slot.session.load(std::memory_order_acquire);
+      
+      if (session <= 0) {
+        continue;
+      }
+      
+      const char *name = kSessionNames[metric];
+      
+      switch (metric) {
+        
+        case 0:
+          Append(out, "%s{session=\"%ld\"} %ld\n", name, session,
+                 slot.ticks.load(std::memory_order_relaxed) - slot.base_ticks.load(std::memory_order_relaxed));
+          break;
+        
+        case 1:
+          Append(out, "%s{session=\"%ld\"} %ld\n", name, session,
+                 slot.resets.load(std::memory_order_relaxed) - slot.base_resets.load(std::memory_order_relaxed));
+          break;
+        
+        case 2:
+          Append(out, "%s{session=\"%ld\"} %ld\n", name, session,
+                 slot.twiddles.load(std::memory_order_relaxed) - slot.base_twiddles.load(std::memory_order_relaxed));
+          break;
+        
+        case 3:
+          Append(out, "%s{session=\"%ld\"} %.17g\n", name, session, slot.best_error.load(std::memory_order_relaxed));
+          break;
+        
+        case 4:
+          Append(out, "%s{session=\"%ld\"} %.17g\n", name, session, slot.error.load(std::memory_order_relaxed));
+          break;
+        
+        case 5:
+          for (int term = 0; term < 3; ++term) {
+            Append(out, "%s{session=\"%ld\",term=\"%s\"} %.17g\n", name, session, kTerms[term],
+                   slot.gains[term].load(std::memory_order_relaxed));
+          }
+          break;
+        
+        case 6:
+          Append(out, "%s{session=\"%ld\"} %.17g\n", name, session, slot.increments.load(std::memory_order_relaxed));
+          break;
+        
+        case 7:
+          Append(out, "%s{session=\"%ld\"} %d\n", name, session, slot.index.load(std::memory_order_relaxed));
+          break;
+        
+        case 8:
+          Append(out, "%s{session=\"%ld\"} %d\n", name, session, slot.order.load(std::memory_order_relaxed));
+          break;
+        
+      } // End switch
+      
+    }
+    
+  }
+  
+}
+
+
+// Constructor
+MetricsRenderer::MetricsRenderer(const MetricsRegistry &registry, int refresh_milliseconds)
+  : registry(registry), interval(refresh_milliseconds), body(std::make_shared<const std::string>()), stopping(false) {}
+
+
+// Stops the render thread
+MetricsRenderer::~MetricsRenderer() {
+  
+  Stop();
+  
+}
+
+
+// Renders one page
+std::shared_ptr<const std::string> MetricsRenderer::Render() const {
+  
+  std::shared_ptr<std::string> page = std::make_shared<std::string>();
+  page->reserve(16384);
+  registry.Render(*page);
+  
+  return page;
+  
+}
+
+
+// Renders the first page and starts the render thread
+void MetricsRenderer::Start() {
+  
+  if (renderer.joinable()) {
+    return;
+  }
+  
+  std::shared_ptr<const std::string> page = Render();
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  body = page;
+  stopping = false;
+  renderer = std::thread(&MetricsRenderer::Run, this);
+  
+}
+
+
+// Stops the render thread
+void MetricsRenderer::Stop() {
+  
+  if (!renderer.joinable()) {
+    return;
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    changed.notify_all();
+  }
+  
+  renderer.join();
+  
+}
+
+
+// Renders a page every interval until stopped
+void MetricsRenderer::Run() {
+  
+  std::unique_lock<std::mutex> lock(mutex);
+  
+  while (!changed.wait_for(lock, interval, [this] { return stopping; })) {
+    
+    lock.unlock();
+    std::shared_ptr<const std::string> page = Render();
+    lock.lock();
+    
+    body.swap(page);
+    
+  }
+  
+}
+
+
+// Latest page
+std::shared_ptr<const std::string> MetricsRenderer::Body() const {
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  
+  return body;
+  
+}
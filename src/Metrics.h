@@ -0,0 +1,149 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Controller.h"
+#include "Pipeline.h"
+#include "StageTimer.h"
+
+// Metrics of the session using a slot of the registry
+// Written by the one thread running the session's controller, read by any thread rendering
+// the metrics; every field is an atomic accessed with relaxed ordering, so neither side waits
+struct alignas(64) SessionMetrics {
+  
+  // Id of the session using the slot, 0 when free and -1 while being claimed
+  std::atomic<long> session;
+  
+  // Counts over every session that used the slot, so that the totals never go down
+  std::atomic<long> ticks;
+  std::atomic<long> resets;
+  std::atomic<long> twiddles;
+  
+  // Counts when the current session claimed the slot
+  std::atomic<long> base_ticks;
+  std::atomic<long> base_resets;
+  std::atomic<long> base_twiddles;
+  
+  // Twiddle progress of the steering controller
+  std::atomic<double> best_error;
+  std::atomic<double> error;
+  std::atomic<double> gains[3];
+  std::atomic<double> increments;
+  std::atomic<int> index;
+  std::atomic<int> order;
+  
+};
+
+// Lock-free metrics of the server, rendered in the Prometheus text format
+// Sessions claim one of a fixed number of slots; when all are taken a session runs without metrics.
+class MetricsRegistry {
+  
+public:
+  
+  // Number of session slots
+  static const int kMaxSessions = 256;
+  
+private:
+  
+  SessionMetrics sessions[kMaxSessions];
+  
+  std::atomic<long> sessions_opened;
+  std::atomic<long> sessions_open;
+  
+  // Per event loop histograms and pipeline counters, owned by main
+  const std::vector<StageHistograms> *histograms;
+  const std::vector<PipelineCounters> *pipelines;
+  
+public:
+  
+  // Constructor
+  MetricsRegistry();
+  
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+  
+  // Adds the stage histograms and pipeline counters of the event loops to the metrics
+  // Must be called before the event loops start
+  void Attach(const std::vector<StageHistograms> *histograms, const std::vector<PipelineCounters> *pipelines);
+  
+  // Counts a new session and returns its id, counted from 1
+  long OpenSession();
+  
+  // Counts a closed session and returns the number of sessions still open
+  long CloseSession();
+  
+  // Number of sessions open
+  long SessionsOpen() const;
+  
+  // Claims a slot for the session, nullptr if every slot is taken
+  SessionMetrics *Acquire(long session);
+  
+  // Frees a slot once the session's controller will not run again
+  void Release(SessionMetrics *metrics);
+  
+  // Appends the metrics to out in the Prometheus text format
+  void Render(std::string &out) const;
+  
+};
+
+// Renders the metrics on its own thread at a fixed interval
+// Serving /metrics only copies a pointer to the latest page, so scrapes never format on an event loop.
+class MetricsRenderer {
+  
+private:
+  
+  const MetricsRegistry &registry;
+  std::chrono::milliseconds interval;
+  
+  // Latest page, replaced under the mutex by the render thread
+  mutable std::mutex mutex;
+  std::condition_variable changed;
+  std::shared_ptr<const std::string> body;
+  bool stopping;
+  
+  std::thread renderer;
+  
+  // Renders one page
+  std::shared_ptr<const std::string> Render() const;
+  
+  // Renders a page every interval until stopped
+  void Run();
+  
+public:
+  
+  // Milliseconds between renders by default
+  static const int kRefreshMilliseconds = 1000;
+  
+  // Constructor
+  explicit MetricsRenderer(const MetricsRegistry &registry, int refresh_milliseconds = kRefreshMilliseconds);
+  
+  // Stops the render thread
+  ~MetricsRenderer();
+  
+  MetricsRenderer(const MetricsRenderer &) = delete;
+  MetricsRenderer &operator=(const MetricsRenderer &) = delete;
+  
+  // Renders the first page and starts the render thread
+  // Must be called after the registry's histograms and counters are attached
+  void Start();
+  
+  // Stops the render thread, the latest page is still served
+  void Stop();
+  
+  // Latest page, at most one interval old, or an empty page before Start
+  std::shared_ptr<const std::string> Body() const;
+  
+};
+
+// Publishes the state of the controller after a tick, does nothing if metrics is nullptr
+void PublishTick(SessionMetrics *metrics, const Controller &controller, const ControlCommand &command);
+
+#endif // METRICS_H
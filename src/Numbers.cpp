@@ -0,0 +1,465 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <locale.h>
+
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
+#include "Numbers.h"
+
+
+// Powers of ten that are exactly representable as doubles
+static const double kExactPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Largest integer below which every integer is exactly representable as a double
+static const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+
+// Longest number handed to the slow path
+static const size_t kMaxSlowPathLength = 127;
+
+
+// Converts with strtod in the C locale for the inputs the fast path cannot round exactly
+static bool ParseSlowPath(const char *begin, const char *end, double &value) {
+  
+  static locale_t c_locale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+  
+  size_t n = end - begin;
+  
+  if (n > kMaxSlowPathLength || c_locale == (locale_t) 0) {
+    return false;
+  }
+  
+  // Copying the number to a stack buffer because strtod needs a terminated string
+  char buffer[kMaxSlowPathLength + 1];
+  memcpy(buffer, begin, n);
+  buffer[n] = '\0';
+  
+  value = strtod_l(buffer, nullptr, c_locale);
+  
+  return true;
+  
+}
+
+
+// Parses a decimal number from [begin, end)
+const char *ParseDouble(const char *begin, const char *end, double &value) {
+  
+  const char *c = begin;
+  bool negative = false;
+  
+  if (c != end && (*c == '-' || *c == '+')) {
+    negative = *c == '-';
+    ++c;
+  }
+  
+  // Accumulating up to 19 significant digits in an integer mantissa
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool truncated = false;
+  
+  const char *digits_begin = c;
+  
+  // Integer part
+  while (c != end && *c >= '0' && *c <= '9') {
+    
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*c - '0');
+      digits += mantissa != 0;
+    }
+    
+    else {
+      exponent += 1;
+      truncated |= *c != '0';
+    }
+    
+    ++c;
+    
+  }
+  
+  bool has_digits = c != digits_begin;
+  
+  // Fractional part
+  if (c != end && *c == '.') {
+    
+    ++c;
+    const char *fraction_begin = c;
+    
+    while (c != end && *c >= '0' && *c <= '9') {
+      
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*c - '0');
+        digits += mantissa != 0;
+        exponent -= 1;
+      }
+      
+      else {
+        truncated |= *c != '0';
+      }
+      
+      ++c;
+      
+    }
+    
+    has_digits |= c != fraction_begin;
+    
+  }
+  
+  if (!has_digits) {
+    return nullptr;
+  }
+  
+  // Exponent part
+  if (c != end && (*c == 'e' || *c == 'E')) {
+    
+    const char *e = c + 1;
+    bool negative_exponent = false;
+    
+    if (e != end && (*e == '-' || *e == '+')) {
+      negative_exponent = *e == '-';
+      ++e;
+    }
+    
+    if (e != end && *e >= '0' && *e <= '9') {
+      
+      int explicit_exponent = 0;
+      
+      while (e != end && *e >= '0' && *e <= '9') {
+        
+        if (explicit_exponent < 100000) {
+          explicit_exponent = explicit_exponent * 10 + (*e - '0');
+        }
+        
+        ++e;
+        
+      }
+      
+      exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+      c = e;
+      
+    }
+    
+  }
+  
+  // Fast path: an exact mantissa scaled by an exact power of ten is rounded once
+  if (!truncated && mantissa <= kMaxExactMantissa && exponent >= -22 && exponent <= 22) {
+    
+    double result = static_cast<double>(mantissa);
+    
+    if (exponent < 0) {
+      result /= kExactPowersOfTen[-exponent];
+    }
+    
+    else {
+      result *= kExactPowersOfTen[exponent];
+    }
+    
+    value = negative ? -result : result;
+    
+    return c;
+    
+  }
+  
+  if (mantissa == 0 && !truncated) {
+    value = negative ? -0.0 : 0.0;
+    return c;
+  }
+  
+  if (!ParseSlowPath(begin, c, value)) {
+    return nullptr;
+  }
+  
+  return c;
+  
+}
+
+
+// Formatting with 15 significant digits, as %.15g and so json.hpp do
+// Values from about 1e-13 to 1e15 are rounded exactly with 128 bit integer arithmetic,
+// which covers every controller output; the others are written with snprintf
+
+
+// Significant digits written
+static const int kSignificantDigits = 15;
+
+// Bounds of an integer with kSignificantDigits digits
+static const uint64_t kMinSignificand = 100000000000000ULL;
+static const uint64_t kMaxSignificand = 1000000000000000ULL;
+
+// Powers of five up to the largest that fits in 63 bits
+static const int kMaxPowerOfFive = 27;
+
+static const uint64_t kPowersOfFive[kMaxPowerOfFive + 1] = {
+  1, 5, 25, 125,
+  625, 3125, 15625, 78125,
+  390625, 1953125, 9765625, 48828125,
+  244140625, 1220703125, 6103515625ULL, 30517578125ULL,
+  152587890625ULL, 762939453125ULL, 3814697265625ULL, 19073486328125ULL,
+  95367431640625ULL, 476837158203125ULL, 2384185791015625ULL, 11920928955078125ULL,
+  59604644775390625ULL, 298023223876953125ULL, 1490116119384765625ULL, 7450580596923828125ULL
+};
+
+
+// Rounds mantissa * 2^exponent * 10^power to the nearest integer, ties to even as printf does
+// Returns false if the product does not fit the 128 bit arithmetic
+static bool ScaleAndRound(uint64_t mantissa, int exponent, int power, uint64_t &result) {
+  
+  if (power < 0 || power > kMaxPowerOfFive) {
+    return false;
+  }
+  
+  // mantissa * 2^exponent * 10^power = mantissa * 5^power * 2^(exponent + power)
+  unsigned __int128 scaled = static_cast<unsigned __int128>(mantissa) * kPowersOfFive[power];
+  int shift = exponent + power;
+  
+  if (shift >= 0) {
+    
+    if (shift >= 64 || (scaled >> (64 - shift)) != 0) {
+      return false;
+    }
+    
+    result = static_cast<uint64_t>(scaled << shift);
+    
+    return true;
+    
+  }
+  
+  if (-shift >= 128) {
+    return false;
+  }
+  
+  unsigned __int128 quotient = scaled >> -shift;
+  unsigned __int128 remainder = scaled - (quotient << -shift);
+  unsigned __int128 half = static_cast<unsigned __int128>(1) << (-shift - 1);
+  
+  if (remainder > half || (remainder == half && (quotient & 1) != 0)) {
+    quotient += 1;
+  }
+  
+  if ((quotient >> 64) != 0) {
+    return false;
+  }
+  
+  result = static_cast<uint64_t>(quotient);
+  
+  return true;
+  
+}
+
+
+// Rounds a positive finite value to kSignificantDigits digits and drops the trailing zeros
+// The value is then about digits * 10^decimal_exponent
+// Returns false for values outside the range of ScaleAndRound
+static bool RoundToDigits(double value, char *digits, int &length, int &decimal_exponent) {
+  
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  
+  const int biased_exponent = static_cast<int>(bits >> 52) & 0x7FF;
+  
+  // Subnormal numbers are far outside the range
+  if (biased_exponent == 0) {
+    return false;
+  }
+  
+  // value = mantissa * 2^exponent with a 53 bit mantissa
+  const uint64_t mantissa = (bits & ((uint64_t(1) << 52) - 1)) | (uint64_t(1) << 52);
+  const int exponent = biased_exponent - 1075;
+  
+  // Estimating the exponent of the first digit as floor(log10(2^binary_exponent)),
+  // which is at most one below the exact one
+  const int binary_exponent = exponent + 52;
+  int first_digit_exponent = binary_exponent >= 0 ? (binary_exponent * 78913) >> 18
+                                                  : -((-binary_exponent * 78913 + (1 << 18) - 1) >> 18);
+  
+  // Correcting the estimate until the rounded significand has exactly kSignificantDigits digits
+  // A significand rounded up to 10^15 moves the first digit too, as with printf
+  uint64_t significand;
+  
+  while (true) {
+    
+    if (!ScaleAndRound(mantissa, exponent, kSignificantDigits - 1 - first_digit_exponent, significand)) {
+      return false;
+    }
+    
+    if (significand >= kMaxSignificand) {
+      first_digit_exponent += 1;
+    }
+    
+    else if (significand < kMinSignificand) {
+      first_digit_exponent -= 1;
+    }
+    
+    else {
+      break;
+    }
+    
+  }
+  
+  for (int n = kSignificantDigits - 1; n >= 0; --n) {
+    digits[n] = static_cast<char>('0' + significand % 10);
+    significand /= 10;
+  }
+  
+  length = kSignificantDigits;
+  
+  while (length > 1 && digits[length - 1] == '0') {
+    length -= 1;
+  }
+  
+  decimal_exponent = first_digit_exponent - length + 1;
+  
+  return true;
+  
+}
+
+
+// Writes a positive finite value outside the range of RoundToDigits with %.15g
+// Replaces the decimal point of the locale and marks integers with ".0", as json.hpp does
+static size_t FormatWithPrintf(double value, char *out, size_t size) {
+  
+  int length = snprintf(out, size, "%.15g", value);
+  
+  const char decimal_point = localeconv()->decimal_point[0];
+  bool integer = true;
+  
+  for (int n = 0; n < length; ++n) {
+    
+    if (out[n] == decimal_point) {
+      out[n] = '.';
+    }
+    
+    if (out[n] == '.' || out[n] == 'e') {
+      integer = false;
+    }
+    
+  }
+  
+  if (integer) {
+    out[length++] = '.';
+    out[length++] = '0';
+    out[length] = '\0';
+  }
+  
+  return length;
+  
+}
+
+
+// Writes the value with 15 significant digits as json.hpp does
+size_t FormatDouble(double value, char *buffer) {
+  
+  char *out = buffer;
+  
+  // NaN and infinity are not valid JSON numbers
+  if (value != value || value - value != 0.0) {
+    memcpy(buffer, "null", 5);
+    return 4;
+  }
+  
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  
+  if (bits >> 63) {
+    *out++ = '-';
+    value = -value;
+  }
+  
+  if (value == 0.0) {
+    memcpy(out, "0.0", 4);
+    return out + 3 - buffer;
+  }
+  
+  char digits[kSignificantDigits];
+  int length;
+  int decimal_exponent;
+  
+  if (!RoundToDigits(value, digits, length, decimal_exponent)) {
+    return out - buffer + FormatWithPrintf(value, out, kMaxDoubleLength - (out - buffer));
+  }
+  
+  // Exponent of the first digit in scientific notation
+  const int exponent = length + decimal_exponent - 1;
+  
+  // Scientific notation as chosen by %.15g
+  if (exponent < -4 || exponent >= kSignificantDigits) {
+    
+    *out++ = digits[0];
+    
+    if (length > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, length - 1);
+      out += length - 1;
+    }
+    
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    
+    int magnitude = exponent < 0 ? -exponent : exponent;
+    
+    if (magnitude >= 100) {
+      *out++ = static_cast<char>('0' + magnitude / 100);
+      magnitude %= 100;
+    }
+    
+    *out++ = static_cast<char>('0' + magnitude / 10);
+    *out++ = static_cast<char>('0' + magnitude % 10);
+    
+  }
+  
+  // Fixed notation for numbers of at least one
+  else if (exponent >= 0) {
+    
+    const int integer_digits = exponent + 1;
+    
+    if (length > integer_digits) {
+      memcpy(out, digits, integer_digits);
+      out += integer_digits;
+      *out++ = '.';
+      memcpy(out, digits + integer_digits, length - integer_digits);
+      out += length - integer_digits;
+    }
+    
+    else {
+      
+      memcpy(out, digits, length);
+      out += length;
+      
+      for (int n = length; n < integer_digits; ++n) {
+        *out++ = '0';
+      }
+      
+      // Marking integers as floating point numbers
+      *out++ = '.';
+      *out++ = '0';
+      
+    }
+    
+  }
+  
+  // Fixed notation for numbers below one
+  else {
+    
+    *out++ = '0';
+    *out++ = '.';
+    
+    for (int n = -1; n > exponent; --n) {
+      *out++ = '0';
+    }
+    
+    memcpy(out, digits, length);
+    out += length;
+    
+  }
+  
+  *out = '\0';
+  
+  return out - buffer;
+  
+}
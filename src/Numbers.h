@@ -0,0 +1,20 @@
+#ifndef NUMBERS_H
+#define NUMBERS_H
+
+#include <cstddef>
+
+// Parses a decimal number such as "-0.7598" or "1.5e-3" from [begin, end)
+// The result is correctly rounded and does not depend on the locale
+// Returns a pointer past the last character parsed or nullptr if there is no number
+const char *ParseDouble(const char *begin, const char *end, double &value);
+
+// Longest output of FormatDouble including the terminating null
+const size_t kMaxDoubleLength = 32;
+
+// Writes the value as json.hpp does: %.15g, with ".0" appended to integers, a '.' decimal
+// point whatever the locale, and null for NaN and infinity
+// Values from about 1e-13 to 1e15 are rounded with integer arithmetic, without calling printf
+// Returns the number of characters written, not counting the terminating null
+size_t FormatDouble(double value, char *buffer);
+
+#endif // NUMBERS_H
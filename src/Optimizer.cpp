@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <math.h>
+
+#include "Controller.h"
+#include "Optimizer.h"
+
+
+// Constructor
+TwiddleOptimizer::TwiddleOptimizer(const PDController &pid) : pid(pid), last(pid.gains), best(pid.gains),
+                                                             best_error(INFINITY) {}
+
+
+// Name of the method
+const char *TwiddleOptimizer::Name() const {
+  
+  return "Twiddle";
+  
+}
+
+
+// Gains to score next
+Gains TwiddleOptimizer::Next() {
+  
+  last = pid.gains;
+  
+  return last;
+  
+}
+
+
+// Reports the error of the gains returned by the last call to Next
+void TwiddleOptimizer::Report(double error) {
+  
+  if (error < best_error) {
+    best_error = error;
+    best = last;
+  }
+  
+  // Twiddle scores the gains it set in the previous call with the accumulated error
+  pid.ResetError();
+  pid.sum_squared_error = error;
+  pid.iterations = 1;
+  
+  pid.Twiddle();
+  
+}
+
+
+// Best gains scored so far
+Gains TwiddleOptimizer::Best() const {
+  
+  return best;
+  
+}
+
+
+// Error of the best gains scored so far
+double TwiddleOptimizer::BestError() const {
+  
+  return best_error;
+  
+}
+
+
+// Gain increments
+Gains TwiddleOptimizer::Steps() const {
+  
+  return pid.gain_increments;
+  
+}
+
+
+// Converged once the sum of the gain increments falls to kTuningThreshold
+bool TwiddleOptimizer::Converged() const {
+  
+  // CalculateSum is not const
+  PDController copy = pid;
+  
+  return copy.CalculateSum() <= kTuningThreshold;
+  
+}
+
+
+// Constructor
+NelderMeadOptimizer::NelderMeadOptimizer(const Gains &gains, const Gains &steps)
+  : step(Step::kInitial), vertex(0), centroid(gains), outside(false), point(gains) {
+  
+  simplex.push_back(Vertex{gains, INFINITY});
+  
+  for (size_t i = 0; i < gains.size(); ++i) {
+    
+    if (steps[i] == 0.0) {
+      continue;
+    }
+    
+    Gains moved = gains;
+    moved[i] += steps[i];
+    
+    dimensions.push_back(i);
+    simplex.push_back(Vertex{moved, INFINITY});
+    
+  }
+  
+  reflected = simplex[0];
+  best = simplex[0];
+  
+}
+
+
+// Name of the method
+const char *NelderMeadOptimizer::Name() const {
+  
+  return "Nelder-Mead";
+  
+}
+
+
+// Point at coefficient times the way from the centroid to a vertex
+Gains NelderMeadOptimizer::Along(const Gains &from, double coefficient) const {
+  
+  Gains gains = centroid;
+  
+  for (size_t i : dimensions) {
+    
+    gains[i] = centroid[i] + coefficient * (from[i] - centroid[i]);
+    
+    // Ensuring that the PID gain stays positive
+    if (gains[i] < 0.0) {
+      gains[i] = 0.0;
+    }
+    
+  }
+  
+  return gains;
+  
+}
+
+
+// Sorts the simplex and reflects its worst vertex
+void NelderMeadOptimizer::Iterate() {
+  
+  std::stable_sort(simplex.begin(), simplex.end(),
+                   [](const Vertex &a, const Vertex &b) { return a.error < b.error; });
+  
+  // Centroid of every vertex but the worst
+  for (size_t i : dimensions) {
+    
+    double sum = 0.0;
+    
+    for (size_t k = 0; k + 1 < simplex.size(); ++k) {
+      sum += simplex[k].gains[i];
+    }
+    
+    centroid[i] = sum / (simplex.size() - 1);
+    
+  }
+  
+  step = Step::kReflect;
+  
+}
+
+
+// Replaces the worst vertex and starts the next iteration
+void NelderMeadOptimizer::Replace(const Vertex &replacement) {
+  
+  simplex.back() = replacement;
+  Iterate();
+  
+}
+
+
+// Gains to score next
+Gains NelderMeadOptimizer::Next() {
+  
+  switch (step) {
+    
+    case Step::kInitial:
+      point = simplex[vertex].gains;
+      break;
+    
+    case Step::kReflect:
+      point = Along(simplex.back().gains, -1.0);
+      break;
+    
+    case Step::kExpand:
+      point = Along(simplex.back().gains, -2.0);
+      break;
+    
+    // Outside contraction between the centroid and the reflected point, inside contraction
+    // between the centroid and the worst vertex
+    case Step::kContract:
+      point = Along(simplex.back().gains, outside ? -0.5 : 0.5);
+      break;
+    
+    // Every vertex but the best moves halfway towards the best
+    case Step::kShrink:
+      point = simplex[vertex].gains;
+      for (size_t i : dimensions) {
+        point[i] = simplex[0].gains[i] + 0.5 * (simplex[vertex].gains[i] - simplex[0].gains[i]);
+      }
+      break;
+    
+  }
+  
+  return point;
+  
+}
+
+
+// Reports the error of the gains returned by the last call to Next
+void NelderMeadOptimizer::Report(double error) {
+  
+  Vertex scored = {point, error};
+  
+  if (error < best.error) {
+    best = scored;
+  }
+  
+  switch (step) {
+    
+    case Step::kInitial: {
+      
+      simplex[vertex] = scored;
+      vertex += 1;
+      
+      if (vertex == simplex.size()) {
+        Iterate();
+      }
+      
+      break;
+      
+    }
+    
+    case Step::kReflect: {
+      
+      reflected = scored;
+      
+      const Vertex &second_worst = simplex[simplex.size() - 2];
+      
+      // Trying further out if the reflection is the new best vertex
+      if (error < simplex[0].error) {
+        step = Step::kExpand;
+      }
+      
+      else if (error < second_worst.error) {
+        Replace(reflected);
+      }
+      
+      else {
+        outside = error < simplex.back().error;
+        step = Step::kContract;
+      }
+      
+      break;
+      
+    }
+    
+    case Step::kExpand: {
+      
+      Replace(error < reflected.error ? scored : reflected);
+      
+      break;
+      
+    }
+    
+    case Step::kContract: {
+      
+      if (outside ? error <= reflected.error : error < simplex.back().error) {
+        Replace(scored);
+      }
+      
+      // Shrinking the simplex if contracting did not improve on the worst point
+      else {
+        step = Step::kShrink;
+        vertex = 1;
+      }
+      
+      break;
+      
+    }
+    
+    case Step::kShrink: {
+      
+      simplex[vertex] = scored;
+      vertex += 1;
+      
+      if (vertex == simplex.size()) {
+        Iterate();
+      }
+      
+      break;
+      
+    }
+    
+  }
+  
+}
+
+
+// Best gains scored so far
+Gains NelderMeadOptimizer::Best() const {
+  
+  return best.gains;
+  
+}
+
+
+// Error of the best gains scored so far
+double NelderMeadOptimizer::BestError() const {
+  
+  return best.error;
+  
+}
+
+
+// Extent of the simplex along each gain
+Gains NelderMeadOptimizer::Steps() const {
+  
+  Gains steps = {0.0, 0.0, 0.0};
+  
+  for (size_t i : dimensions) {
+    
+    double low = INFINITY;
+    double high = -INFINITY;
+    
+    for (const Vertex &v : simplex) {
+      low = std::min(low, v.gains[i]);
+      high = std::max(high, v.gains[i]);
+    }
+    
+    steps[i] = high - low;
+    
+  }
+  
+  return steps;
+  
+}
+
+
+// Converged once the sum of the simplex's extents falls to kTuningThreshold
+bool NelderMeadOptimizer::Converged() const {
+  
+  if (step == Step::kInitial) {
+    return false;
+  }
+  
+  Gains steps = Steps();
+  
+  return steps[0] + steps[1] + steps[2] <= kTuningThreshold;
+  
+}
@@ -0,0 +1,154 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "PID.h"
+#include "Tuning.h"
+
+// Search over the steering gains driven by episode scores
+// The tuning loop asks for the gains to drive next, scores them with one episode
+// and reports the episode's mean squared cross track error back
+class Optimizer {
+  
+public:
+  
+  virtual ~Optimizer() {}
+  
+  // Name of the method, for reports
+  virtual const char *Name() const = 0;
+  
+  // Gains to score next
+  virtual Gains Next() = 0;
+  
+  // Reports the error of the gains returned by the last call to Next
+  virtual void Report(double error) = 0;
+  
+  // Best gains scored so far and their error
+  virtual Gains Best() const = 0;
+  virtual double BestError() const = 0;
+  
+  // Current step of the search along each gain
+  virtual Gains Steps() const = 0;
+  
+  // Checks if the search has shrunk to kTuningThreshold
+  virtual bool Converged() const = 0;
+  
+};
+
+// Coordinate-wise twiddle with PDController::Twiddle
+// Changes one gain per episode and skips the integral gain
+class TwiddleOptimizer : public Optimizer {
+  
+private:
+  
+  // Controller whose gains are twiddled, scored through its accumulated error
+  PDController pid;
+  
+  // Gains returned by Next
+  Gains last;
+  
+  Gains best;
+  double best_error;
+  
+public:
+  
+  // Constructor
+  // Starts from the controller's gains and increments
+  explicit TwiddleOptimizer(const PDController &pid);
+  
+  const char *Name() const override;
+  Gains Next() override;
+  void Report(double error) override;
+  Gains Best() const override;
+  double BestError() const override;
+  Gains Steps() const override;
+  
+  // Converged once the sum of the gain increments falls to kTuningThreshold
+  bool Converged() const override;
+  
+};
+
+// Nelder-Mead downhill simplex
+// Moves all searched gains at once by reflecting, expanding and contracting a simplex of
+// n + 1 gain vectors away from its worst vertex, so it needs no gradient and no step schedule
+// Gains are kept positive as in twiddle
+class NelderMeadOptimizer : public Optimizer {
+  
+private:
+  
+  // Vertex of the simplex
+  struct Vertex {
+    
+    Gains gains;
+    double error;
+    
+  };
+  
+  // Step of the current iteration, each evaluating one point
+  enum class Step {
+    kInitial,    // scoring the vertices of the initial simplex
+    kReflect,    // scoring the worst vertex reflected through the centroid of the others
+    kExpand,     // scoring a point further out than an improving reflection
+    kContract,   // scoring a point between the centroid and the reflection or the worst vertex
+    kShrink      // scoring the vertices moved halfway towards the best vertex
+  };
+  
+  // Indices of the searched gains
+  std::vector<size_t> dimensions;
+  
+  // Vertices sorted by error once the initial simplex has been scored
+  std::vector<Vertex> simplex;
+  
+  Step step;
+  
+  // Vertex scored next while in kInitial or kShrink
+  size_t vertex;
+  
+  // Centroid of all vertices but the worst
+  Gains centroid;
+  
+  // Reflected point and its error
+  Vertex reflected;
+  
+  // Contracting towards the reflected point rather than the worst vertex
+  bool outside;
+  
+  // Point returned by Next
+  Gains point;
+  
+  Vertex best;
+  
+  // Point at coefficient times the way from the centroid to a vertex, with negative
+  // coefficients on the far side of the centroid
+  Gains Along(const Gains &from, double coefficient) const;
+  
+  // Replaces the worst vertex and starts the next iteration
+  void Replace(const Vertex &replacement);
+  
+  // Sorts the simplex and reflects its worst vertex
+  void Iterate();
+  
+public:
+  
+  // Constructor
+  // The initial simplex is the gains and, for each gain with a non-zero step, the gains with that
+  // gain moved by its step, so it starts as large as twiddle's increments
+  NelderMeadOptimizer(const Gains &gains, const Gains &steps);
+  
+  const char *Name() const override;
+  Gains Next() override;
+  void Report(double error) override;
+  Gains Best() const override;
+  double BestError() const override;
+  
+  // Extent of the simplex along each gain
+  Gains Steps() const override;
+  
+  // Converged once the sum of the simplex's extents falls to kTuningThreshold
+  bool Converged() const override;
+  
+};
+
+#endif // OPTIMIZER_H
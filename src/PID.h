@@ -1,68 +1,36 @@
 #ifndef PID_H
 #define PID_H
 
-class PID {
+#include <type_traits>
 
-private:
-  
-  // PID errors
-  double p_error;
-  double i_error;
-  double d_error;
-  double cte_past;
-  
-  // Increments the index of the PID gain being tuned
-  // Skips the integral gain
-  // Resets the tuning order
-  void IncrementIndex();
-  
-public:
-  
-  // PID gains
-  std::vector<double> gains;
-  
-  // PID gain increments used for tuning
-  std::vector<double> gain_increments;
-  
-  // Index of the PID gain being tuned
-  int i;
-  
-  // Tuning order
-  int order;
-  
-  // Accumulated mean squared error variables
-  int iterations;
-  double sum_squared_error;
-  double best_error;
-  
-  // Constructor
-  PID();
+#include "FixedPoint.h"
+#include "PIDController.h"
 
-  // Destructor
-  virtual ~PID();
+// Double precision controller with all three terms
+typedef PIDController<double, kPID> PID;
 
-  // Initializes the PID controller
-  void Init(double Kp, double Ki, double Kd,
-            double Kp_inc, double Ki_inc, double Kd_inc);
+// Double precision controller without the integral term
+// Used where the integral gain is 0, such as steering in the simulator
+typedef PIDController<double, kPD> PDController;
 
-  // Updates the PID errors given cross track error
-  void UpdateError(double error);
-  
-  // Calculates the total PID error
-  double TotalError();
-  
-  // Calculates the sum of the PID gain increments
-  double CalculateSum();
-  
-  // Calcuates the accumulated mean squared error
-  double CalculateError();
-  
-  // Resets the PID and accumulated mean squared errors
-  void ResetError();
-  
-  // Tunes the PID gains
-  void Twiddle();
-  
-};
+// Single precision controller with all three terms
+typedef PIDController<float, kPID> FloatPID;
+
+// Fixed-point scalar with 32 fractional bits, see FixedPoint for its range
+typedef FixedPoint<32> Fixed32;
+
+// Fixed-point controller with all three terms, for targets without a floating point unit
+typedef PIDController<Fixed32, kPID> FixedPID;
+
+// Instantiated once in PID.cpp
+extern template class PIDController<double, kPID>;
+extern template class PIDController<double, kPD>;
+extern template class PIDController<float, kPID>;
+extern template class PIDController<Fixed32, kPID>;
+
+// PID state is stored inline so that controllers can be copied with memcpy
+// and packed contiguously
+static_assert(std::is_trivially_copyable<PID>::value, "PID must be trivially copyable");
+static_assert(sizeof(PID) <= 128, "PID must fit in two cache lines");
 
 #endif // PID_H
@@ -0,0 +1,352 @@
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "CpuFeatures.h"
+#include "PIDBank.h"
+
+
+// Kernels
+// Each kernel processes controllers [begin, end) and returns where it stopped
+// so that the remainder can be handed to the scalar kernel.
+// The operations are performed in the same order as in PID so that the
+// results are bit for bit identical.
+
+struct BankState {
+  
+  const double *kp;
+  const double *ki;
+  const double *kd;
+  double *p_error;
+  double *i_error;
+  double *d_error;
+  double *cte_past;
+  double *sum_squared_error;
+  
+};
+
+// Read-only view of the gains and errors used by the TotalError kernels
+struct BankView {
+  
+  const double *kp;
+  const double *ki;
+  const double *kd;
+  const double *p_error;
+  const double *i_error;
+  const double *d_error;
+  
+};
+
+
+static void UpdateErrorScalar(const BankState &s, const double *errors, size_t stride,
+                              size_t begin, size_t end) {
+  
+  for (size_t k = begin; k < end; ++k) {
+    
+    double error = errors[k * stride];
+    
+    s.p_error[k] = error;
+    s.i_error[k] += error;
+    s.d_error[k] = error - s.cte_past[k];
+    s.cte_past[k] = error;
+    s.sum_squared_error[k] += error * error;
+    
+  }
+  
+}
+
+
+static void TotalErrorScalar(const BankView &s, double *outputs, size_t begin, size_t end) {
+  
+  for (size_t k = begin; k < end; ++k) {
+    outputs[k] = s.kp[k] * s.p_error[k] + s.ki[k] * s.i_error[k] + s.kd[k] * s.d_error[k];
+  }
+  
+}
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+static size_t UpdateErrorAvx2(const BankState &s, const double *errors, size_t stride, size_t end) {
+  
+  size_t k = 0;
+  
+  for (; k + 4 <= end; k += 4) {
+    
+    __m256d error = stride == 0 ? _mm256_set1_pd(errors[0]) : _mm256_loadu_pd(errors + k);
+    __m256d cte_past = _mm256_loadu_pd(s.cte_past + k);
+    
+    _mm256_storeu_pd(s.p_error + k, error);
+    _mm256_storeu_pd(s.i_error + k, _mm256_add_pd(_mm256_loadu_pd(s.i_error + k), error));
+    _mm256_storeu_pd(s.d_error + k, _mm256_sub_pd(error, cte_past));
+    _mm256_storeu_pd(s.cte_past + k, error);
+    _mm256_storeu_pd(s.sum_squared_error + k,
+                     _mm256_add_pd(_mm256_loadu_pd(s.sum_squared_error + k), _mm256_mul_pd(error, error)));
+    
+  }
+  
+  return k;
+  
+}
+
+
+__attribute__((target("avx2")))
+static size_t TotalErrorAvx2(const BankView &s, double *outputs, size_t end) {
+  
+  size_t k = 0;
+  
+  for (; k + 4 <= end; k += 4) {
+    
+    __m256d p = _mm256_mul_pd(_mm256_loadu_pd(s.kp + k), _mm256_loadu_pd(s.p_error + k));
+    __m256d i = _mm256_mul_pd(_mm256_loadu_pd(s.ki + k), _mm256_loadu_pd(s.i_error + k));
+    __m256d d = _mm256_mul_pd(_mm256_loadu_pd(s.kd + k), _mm256_loadu_pd(s.d_error + k));
+    
+    _mm256_storeu_pd(outputs + k, _mm256_add_pd(_mm256_add_pd(p, i), d));
+    
+  }
+  
+  return k;
+  
+}
+
+
+__attribute__((target("avx512f")))
+static size_t UpdateErrorAvx512(const BankState &s, const double *errors, size_t stride, size_t end) {
+  
+  size_t k = 0;
+  
+  for (; k + 8 <= end; k += 8) {
+    
+    __m512d error = stride == 0 ? _mm512_set1_pd(errors[0]) : _mm512_loadu_pd(errors + k);
+    __m512d cte_past = _mm512_loadu_pd(s.cte_past + k);
+    
+    _mm512_storeu_pd(s.p_error + k, error);
+    _mm512_storeu_pd(s.i_error + k, _mm512_add_pd(_mm512_loadu_pd(s.i_error + k), error));
+    _mm512_storeu_pd(s.d_error + k, _mm512_sub_pd(error, cte_past));
+    _mm512_storeu_pd(s.cte_past + k, error);
+    _mm512_storeu_pd(s.sum_squared_error + k,
+                     _mm512_add_pd(_mm512_loadu_pd(s.sum_squared_error + k), _mm512_mul_pd(error, error)));
+    
+  }
+  
+  return k;
+  
+}
+
+
+__attribute__((target("avx512f")))
+static size_t TotalErrorAvx512(const BankView &s, double *outputs, size_t end) {
+  
+  size_t k = 0;
+  
+  for (; k + 8 <= end; k += 8) {
+    
+    __m512d p = _mm512_mul_pd(_mm512_loadu_pd(s.kp + k), _mm512_loadu_pd(s.p_error + k));
+    __m512d i = _mm512_mul_pd(_mm512_loadu_pd(s.ki + k), _mm512_loadu_pd(s.i_error + k));
+    __m512d d = _mm512_mul_pd(_mm512_loadu_pd(s.kd + k), _mm512_loadu_pd(s.d_error + k));
+    
+    _mm512_storeu_pd(outputs + k, _mm512_add_pd(_mm512_add_pd(p, i), d));
+    
+  }
+  
+  return k;
+  
+}
+
+
+#endif
+
+
+// Widest kernel supported by the CPU
+BankKernel BestBankKernel() {
+  
+#if defined(__x86_64__)
+  if (HasAvx512()) {
+    return BankKernel::kAvx512;
+  }
+  
+  if (HasAvx2()) {
+    return BankKernel::kAvx2;
+  }
+#endif
+  
+  return BankKernel::kScalar;
+  
+}
+
+
+// Checks if the CPU supports the kernel
+bool SupportsBankKernel(BankKernel kernel) {
+  
+  switch (kernel) {
+    
+#if defined(__x86_64__)
+    case BankKernel::kAvx512:
+      return HasAvx512();
+    
+    case BankKernel::kAvx2:
+      return HasAvx2();
+#endif
+    
+    case BankKernel::kScalar:
+      return true;
+    
+    default:
+      return false;
+    
+  }
+  
+}
+
+
+static void UpdateErrorKernel(BankKernel kernel, const BankState &s, const double *errors, size_t stride,
+                              size_t n) {
+  
+  size_t k = 0;
+  
+#if defined(__x86_64__)
+  if (kernel == BankKernel::kAvx512) {
+    k = UpdateErrorAvx512(s, errors, stride, n);
+  }
+  
+  else if (kernel == BankKernel::kAvx2) {
+    k = UpdateErrorAvx2(s, errors, stride, n);
+  }
+#endif
+  
+  UpdateErrorScalar(s, errors, stride, k, n);
+  
+}
+
+
+static void TotalErrorKernel(BankKernel kernel, const BankView &s, double *outputs, size_t n) {
+  
+  size_t k = 0;
+  
+#if defined(__x86_64__)
+  if (kernel == BankKernel::kAvx512) {
+    k = TotalErrorAvx512(s, outputs, n);
+  }
+  
+  else if (kernel == BankKernel::kAvx2) {
+    k = TotalErrorAvx2(s, outputs, n);
+  }
+#endif
+  
+  TotalErrorScalar(s, outputs, k, n);
+  
+}
+
+
+// Constructor
+PIDBank::PIDBank(size_t size, BankKernel kernel)
+  : n(size), kernel(kernel), kp(size, 0.0), ki(size, 0.0), kd(size, 0.0),
+    p_error(size, 0.0), i_error(size, 0.0), d_error(size, 0.0), cte_past(size, 0.0),
+    iterations(size, 0), sum_squared_error(size, 0.0) {}
+
+
+// Number of controllers
+size_t PIDBank::Size() const {
+  
+  return n;
+  
+}
+
+
+// Initializes controller k with the given gains and clears its errors
+void PIDBank::Init(size_t k, double Kp, double Ki, double Kd) {
+  
+  // PID gains
+  kp[k] = Kp;
+  ki[k] = Ki;
+  kd[k] = Kd;
+  
+  // PID errors
+  p_error[k] = 0.0;
+  i_error[k] = 0.0;
+  d_error[k] = 0.0;
+  cte_past[k] = 0.0;
+  
+  // Accumulated mean squared error variables
+  iterations[k] = 0;
+  sum_squared_error[k] = 0.0;
+  
+}
+
+
+// Initializes controller k with the gains of a PID controller and clears its errors
+void PIDBank::Init(size_t k, const PID &pid) {
+  
+  Init(k, pid.gains[0], pid.gains[1], pid.gains[2]);
+  
+}
+
+
+// Updates the PID errors of every controller given one cross track error per controller
+void PIDBank::UpdateError(const double *errors) {
+  
+  BankState s = {kp.data(), ki.data(), kd.data(), p_error.data(), i_error.data(),
+                 d_error.data(), cte_past.data(), sum_squared_error.data()};
+  
+  UpdateErrorKernel(kernel, s, errors, 1, n);
+  
+  for (size_t k = 0; k < n; ++k) {
+    iterations[k] += 1;
+  }
+  
+}
+
+
+// Updates the PID errors of every controller given the same cross track error
+void PIDBank::UpdateError(double error) {
+  
+  BankState s = {kp.data(), ki.data(), kd.data(), p_error.data(), i_error.data(),
+                 d_error.data(), cte_past.data(), sum_squared_error.data()};
+  
+  UpdateErrorKernel(kernel, s, &error, 0, n);
+  
+  for (size_t k = 0; k < n; ++k) {
+    iterations[k] += 1;
+  }
+  
+}
+
+
+// Calculates the total PID error of every controller
+void PIDBank::TotalError(double *outputs) const {
+  
+  BankView s = {kp.data(), ki.data(), kd.data(), p_error.data(), i_error.data(), d_error.data()};
+  
+  TotalErrorKernel(kernel, s, outputs, n);
+  
+}
+
+
+// Calculates the accumulated mean squared error of controller k
+double PIDBank::CalculateError(size_t k) const {
+  
+  if (iterations[k] == 0) {
+    return 0;
+  }
+  
+  else {
+    return sum_squared_error[k] / iterations[k];
+  }
+  
+}
+
+
+// Resets the PID and accumulated mean squared errors of every controller
+void PIDBank::ResetError() {
+  
+  std::fill(p_error.begin(), p_error.end(), 0.0);
+  std::fill(i_error.begin(), i_error.end(), 0.0);
+  std::fill(d_error.begin(), d_error.end(), 0.0);
+  std::fill(cte_past.begin(), cte_past.end(), 0.0);
+  std::fill(iterations.begin(), iterations.end(), 0);
+  std::fill(sum_squared_error.begin(), sum_squared_error.end(), 0.0);
+  
+}
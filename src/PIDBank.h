@@ -0,0 +1,83 @@
+#ifndef PID_BANK_H
+#define PID_BANK_H
+
+#include <cstddef>
+#include <vector>
+
+#include "PID.h"
+
+// Instruction set of the PIDBank kernels
+enum class BankKernel {
+  kScalar,
+  kAvx2,
+  kAvx512
+};
+
+// Widest kernel supported by the CPU
+BankKernel BestBankKernel();
+
+// Checks if the CPU supports the kernel
+bool SupportsBankKernel(BankKernel kernel);
+
+// Structure of arrays holding many PID controllers
+// All controllers are updated with one call using the widest vector
+// instructions supported by the CPU, with results identical to PID
+class PIDBank {
+  
+private:
+  
+  // Number of controllers
+  size_t n;
+  
+  // Kernel used for the vectorized updates
+  BankKernel kernel;
+  
+  // PID gains
+  std::vector<double> kp;
+  std::vector<double> ki;
+  std::vector<double> kd;
+  
+  // PID errors
+  std::vector<double> p_error;
+  std::vector<double> i_error;
+  std::vector<double> d_error;
+  std::vector<double> cte_past;
+  
+  // Accumulated mean squared error variables
+  std::vector<int> iterations;
+  std::vector<double> sum_squared_error;
+  
+public:
+  
+  // Constructor
+  // Uses the widest kernel supported by the CPU unless another one is given,
+  // which must be supported by the CPU
+  explicit PIDBank(size_t size, BankKernel kernel = BestBankKernel());
+  
+  // Number of controllers
+  size_t Size() const;
+  
+  // Initializes controller k with the given gains and clears its errors
+  void Init(size_t k, double Kp, double Ki, double Kd);
+  
+  // Initializes controller k with the gains of a PID controller and clears its errors
+  void Init(size_t k, const PID &pid);
+  
+  // Updates the PID errors of every controller given one cross track error per controller
+  void UpdateError(const double *errors);
+  
+  // Updates the PID errors of every controller given the same cross track error
+  void UpdateError(double error);
+  
+  // Calculates the total PID error of every controller
+  void TotalError(double *outputs) const;
+  
+  // Calculates the accumulated mean squared error of controller k
+  double CalculateError(size_t k) const;
+  
+  // Resets the PID and accumulated mean squared errors of every controller
+  void ResetError();
+  
+};
+
+#endif // PID_BANK_H
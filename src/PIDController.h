@@ -0,0 +1,330 @@
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+#include <array>
+#include <numeric>
+
+// Terms of a PID controller
+enum PIDTerms : unsigned {
+  kProportional = 1,
+  kIntegral = 2,
+  kDerivative = 4,
+  kPD = kProportional | kDerivative,
+  kPID = kProportional | kIntegral | kDerivative
+};
+
+// PID controller with a compile-time scalar type and set of terms
+// Scalar may be float, double or FixedPoint; PID.h instantiates all three and
+// bench_pid checks the float and fixed-point controllers against double
+// The errors of terms missing from Terms are never updated and their
+// products are left out of TotalError, so a PD controller does no integral work
+template <typename Scalar, unsigned Terms>
+class PIDController {
+
+private:
+  
+  static const bool kHasProportional = (Terms & kProportional) != 0;
+  static const bool kHasIntegral = (Terms & kIntegral) != 0;
+  static const bool kHasDerivative = (Terms & kDerivative) != 0;
+  
+  static_assert(Terms != 0 && (Terms & ~unsigned(kPID)) == 0, "Terms must be a non-empty set of PIDTerms");
+  
+  // PID errors
+  // Kept next to the gains so that TotalError touches a single cache line
+  Scalar p_error;
+  Scalar i_error;
+  Scalar d_error;
+  Scalar cte_past;
+  
+  // Increments the index of the PID gain being tuned
+  // Skips the integral gain
+  // Resets the tuning order
+  void IncrementIndex();
+  
+public:
+  
+  // PID gains
+  std::array<Scalar, 3> gains;
+  
+  // PID gain increments used for tuning
+  std::array<Scalar, 3> gain_increments;
+  
+  // Index of the PID gain being tuned
+  int i;
+  
+  // Tuning order
+  int order;
+  
+  // Accumulated mean squared error variables
+  int iterations;
+  Scalar sum_squared_error;
+  Scalar best_error;
+  
+  // Constructor
+  PIDController() {}
+
+  // Initializes the PID controller
+  void Init(Scalar Kp, Scalar Ki, Scalar Kd,
+            Scalar Kp_inc, Scalar Ki_inc, Scalar Kd_inc);
+
+  // Updates the PID errors given cross track error
+  void UpdateError(Scalar error);
+  
+  // Calculates the total PID error
+  Scalar TotalError();
+  
+  // Calculates the sum of the PID gain increments
+  Scalar CalculateSum();
+  
+  // Calcuates the accumulated mean squared error
+  Scalar CalculateError();
+  
+  // Resets the PID and accumulated mean squared errors
+  void ResetError();
+  
+  // Tunes the PID gains
+  void Twiddle();
+  
+};
+
+
+// Initializes the PID controller
+template <typename Scalar, unsigned Terms>
+void PIDController<Scalar, Terms>::Init(Scalar Kp, Scalar Ki, Scalar Kd,
+                                        Scalar Kp_inc, Scalar Ki_inc, Scalar Kd_inc) {
+  
+  // PID gains
+  gains[0] = Kp;
+  gains[1] = Ki;
+  gains[2] = Kd;
+  
+  // PID errors
+  p_error = Scalar(0.0);
+  i_error = Scalar(0.0);
+  d_error = Scalar(0.0);
+  cte_past = Scalar(0.0);
+  
+  // PID gain increments used for tuning
+  gain_increments[0] = Kp_inc;
+  gain_increments[1] = Ki_inc;
+  gain_increments[2] = Kd_inc;
+  
+  // Index of the gain being tuned
+  i = 0;
+  
+  // Tuning order
+  order = 1;
+  
+  // Accumulated mean squared error variables
+  iterations = 0;
+  sum_squared_error = Scalar(0.0);
+  best_error = Scalar(1.0);
+  
+}
+
+
+// Updates the PID errors given cross track error
+template <typename Scalar, unsigned Terms>
+void PIDController<Scalar, Terms>::UpdateError(Scalar error) {
+  
+  // Proportional error
+  if (kHasProportional) {
+    p_error = error;
+  }
+  
+  // Integral error
+  if (kHasIntegral) {
+    i_error += error;
+  }
+  
+  // Derivative error
+  if (kHasDerivative) {
+    d_error = error - cte_past;
+    cte_past = error;
+  }
+  
+  // Accumulated mean squared error
+  iterations += 1;
+  sum_squared_error += error * error;
+  
+}
+
+
+// Calculates the total PID error
+// The enabled terms are added in P, I, D order
+template <typename Scalar, unsigned Terms>
+Scalar PIDController<Scalar, Terms>::TotalError() {
+  
+  Scalar total = kHasProportional ? gains[0] * p_error : Scalar(0.0);
+  
+  if (kHasIntegral) {
+    total = kHasProportional ? total + gains[1] * i_error : gains[1] * i_error;
+  }
+  
+  if (kHasDerivative) {
+    total = (kHasProportional || kHasIntegral) ? total + gains[2] * d_error : gains[2] * d_error;
+  }
+  
+  return total;
+  
+}
+
+
+// Calculates the sum of the PID gain increments
+template <typename Scalar, unsigned Terms>
+Scalar PIDController<Scalar, Terms>::CalculateSum() {
+  
+  return std::accumulate(gain_increments.begin(), gain_increments.end(), Scalar(0.0));
+  
+}
+
+
+// Calculates the accumulated mean squared error
+template <typename Scalar, unsigned Terms>
+Scalar PIDController<Scalar, Terms>::CalculateError() {
+  
+  if (iterations == 0) {
+    return Scalar(0.0);
+  }
+  
+  else {
+    return sum_squared_error / Scalar(iterations);
+  }
+  
+}
+
+
+// Resets the PID and accumulated mean squared errors
+template <typename Scalar, unsigned Terms>
+void PIDController<Scalar, Terms>::ResetError() {
+  
+  // PID errors
+  p_error = Scalar(0.0);
+  i_error = Scalar(0.0);
+  d_error = Scalar(0.0);
+  cte_past = Scalar(0.0);
+  
+  // Accumulated mean squared error
+  iterations = 0;
+  sum_squared_error = Scalar(0.0);
+  
+}
+
+
+// Increments the index of the PID gain being tuned
+// Skips the integral gain
+// Resets the tuning order
+template <typename Scalar, unsigned Terms>
+void PIDController<Scalar, Terms>::IncrementIndex() {
+  
+  // Moving to the next PID gain
+  i = (i + 1) % 3;
+  
+  // Skipping the integral gain
+  // The simulator does not have a steering bias
+  if (i == 1) {
+    i += 1;
+  }
+  
+  // Resetting the order for the next PID gain
+  order = 1;
+  
+}
+
+
+// Tunes the PID gains
+template <typename Scalar, unsigned Terms>
+void PIDController<Scalar, Terms>::Twiddle() {
+  
+  switch (order) {
+      
+    case 1: {
+      
+      // Checking if the the previous twiddle improved the error and distance traveled
+      if (CalculateError() < best_error) {
+        
+        // Setting new improvement requirement
+        best_error = CalculateError();
+        
+        // Increasing the PID gain incrementing value
+        gain_increments[i] *= Scalar(1.1);
+        
+        // Moving to the next PID gain and resetting the tuning order
+        IncrementIndex();
+        
+        // Incrementing the PID gain
+        gains[i] += gain_increments[i];
+        
+        break;
+        
+      }
+      
+      else {
+        
+        // Twiddling in the other direction if the previous twiddle did not improve performance
+        gains[i] -= Scalar(2.0) * gain_increments[i];
+        
+        // Ensuring that the PID gain stays positive
+        if (gains[i] < Scalar(0.0)) {
+          gains[i] = Scalar(0.0);
+        }
+        
+        // On the next twiddle check the effect of this twiddle
+        order = 2;
+        
+        break;
+        
+      }
+      
+    } // End case 1
+      
+    case 2: {
+      
+      // Checking if the the previous twiddle improved the error and distance traveled
+      if (CalculateError() < best_error) {
+        
+        // Setting new improvement requirements
+        best_error = CalculateError();
+        
+        // Increasing the PID gain incrementing value
+        gain_increments[i] *= Scalar(1.1);
+        
+        // Moving to the next PID gain and resetting the tuning order
+        IncrementIndex();
+        
+        // Incrementing the PID gain
+        gains[i] += gain_increments[i];
+        
+        break;
+        
+      }
+      
+      else {
+        
+        // Resetting the PID gain to its value before the first twiddle
+        gains[i] += gain_increments[i];
+        
+        // Decreasing the PID gain incrementing value
+        gain_increments[i] *= Scalar(0.9);
+        
+        // Moving to the next PID gain and resetting the tuning order
+        IncrementIndex();
+        
+        // Incrementing the PID gain
+        gains[i] += gain_increments[i];
+
+        break;
+        
+      }
+      
+    } // End case 2
+      
+  } // End switch
+  
+  // Resetting the accumulated mean squared error
+  iterations = 0;
+  sum_squared_error = Scalar(0.0);
+  
+}
+
+#endif // PID_CONTROLLER_H
@@ -0,0 +1,185 @@
+#include <chrono>
+
+#include "Metrics.h"
+#include "Pipeline.h"
+
+
+// Empty polls before the control thread starts sleeping between polls
+static const int kSpinPolls = 1000;
+
+// Sleep between polls of an idle control thread
+static const std::chrono::microseconds kIdleSleep(50);
+
+
+// Constructor
+ControlPipeline::ControlPipeline(TraceWriter &trace, void (*wake)(void *data), void *wake_data, bool coalescing,
+                                 StageHistograms *histograms, PipelineCounters &counters)
+    : trace(trace), wake(wake), wake_data(wake_data), coalescing(coalescing), histograms(histograms),
+      counters(counters), running(false) {
+  
+}
+
+
+// Stops the control thread
+ControlPipeline::~ControlPipeline() {
+  
+  Stop();
+  
+}
+
+
+// Starts the control thread
+void ControlPipeline::Start() {
+  
+  if (!running.exchange(true)) {
+    control = std::thread(&ControlPipeline::Run, this);
+  }
+  
+}
+
+
+// Stops the control thread
+void ControlPipeline::Stop() {
+  
+  if (running.exchange(false)) {
+    control.join();
+  }
+  
+}
+
+
+// Hands a telemetry frame to the control thread
+bool ControlPipeline::Submit(Session *session, const Telemetry &telemetry) {
+  
+  PipelineFrame frame;
+  frame.session = session;
+  frame.sequence = session->received.load(std::memory_order_relaxed) + 1;
+  frame.telemetry = telemetry;
+  
+  if (!frames.Push(frame)) {
+    counters.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  
+  session->received.store(frame.sequence, std::memory_order_release);
+  session->in_flight += 1;
+  counters.submitted.fetch_add(1, std::memory_order_relaxed);
+  
+  return true;
+  
+}
+
+
+// Takes the next command computed by the control thread
+bool ControlPipeline::Receive(PipelineCommand &command) {
+  
+  return commands.Pop(command);
+  
+}
+
+
+// Runs the controllers until the pipeline is stopped
+void ControlPipeline::Run() {
+  
+  int idle_polls = 0;
+  
+  while (running.load(std::memory_order_relaxed)) {
+    
+    PipelineFrame frame;
+    bool sent = false;
+    
+    // Running every queued frame before waking the event loop once
+    while (frames.Pop(frame)) {
+      
+      Session *session = frame.session;
+      
+      if (session->received.load(std::memory_order_acquire) != frame.sequence) {
+        
+        counters.stale.fetch_add(1, std::memory_order_relaxed);
+        
+        // A newer frame of the session is queued, so only the errors are updated
+        if (coalescing) {
+          session->controller.Skip(frame.telemetry);
+          session->skipped += 1;
+          counters.coalesced.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        
+      }
+      
+      StageTimer timer(histograms);
+      
+      PipelineCommand command;
+      command.session = session;
+      command.command = session->controller.Step(frame.telemetry, timer);
+      command.frames = session->skipped + 1;
+      session->skipped = 0;
+      
+      TraceTick(trace, session->id, session->controller.pid_steering, frame.telemetry, command.command);
+      PublishTick(session->metrics, session->controller, command.command);
+      timer.Lap(kStageLogging);
+      timer.Finish();
+      
+      // The event loop drains the ring on every wake, so waiting here is rare and short
+      while (!commands.Push(command)) {
+        wake(wake_data);
+        std::this_thread::yield();
+      }
+      
+      sent = true;
+      
+    }
+    
+    if (sent) {
+      wake(wake_data);
+      idle_polls = 0;
+    }
+    
+    else if (++idle_polls < kSpinPolls) {
+      std::this_thread::yield();
+    }
+    
+    else {
+      std::this_thread::sleep_for(kIdleSleep);
+    }
+    
+  }
+  
+}
+
+
+// Stage latency histograms shared by the event loop and the control thread
+StageHistograms *ControlPipeline::Histograms() const {
+  
+  return histograms;
+  
+}
+
+
+// Counters
+long ControlPipeline::Submitted() const {
+  
+  return counters.submitted.load(std::memory_order_relaxed);
+  
+}
+
+
+long ControlPipeline::Dropped() const {
+  
+  return counters.dropped.load(std::memory_order_relaxed);
+  
+}
+
+
+long ControlPipeline::Stale() const {
+  
+  return counters.stale.load(std::memory_order_relaxed);
+  
+}
+
+
+long ControlPipeline::Coalesced() const {
+  
+  return counters.coalesced.load(std::memory_order_relaxed);
+  
+}
@@ -0,0 +1,133 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "Controller.h"
+#include "Session.h"
+#include "SpscRing.h"
+#include "StageTimer.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+// Telemetry frame handed from an event loop to its control thread
+struct PipelineFrame {
+  
+  Session *session;
+  
+  // Position of the frame among the session's frames, counted from 1
+  uint64_t sequence;
+  
+  Telemetry telemetry;
+  
+};
+
+// Command handed back from the control thread to the event loop
+struct PipelineCommand {
+  
+  Session *session;
+  ControlCommand command;
+  
+  // Frames the command answers, more than 1 when stale frames were coalesced
+  int frames;
+  
+};
+
+// Counters of a pipeline
+// Owned outside the pipeline so that metrics can read them for the whole life of the process
+struct PipelineCounters {
+  
+  // Frames submitted, and frames dropped because the ring was full
+  // Written by the event loop
+  alignas(64) std::atomic<long> submitted;
+  std::atomic<long> dropped;
+  
+  // Frames that were superseded by a newer frame of their session before the control
+  // thread took them, and stale frames that only updated the PID errors
+  // Written by the control thread
+  alignas(64) std::atomic<long> stale;
+  std::atomic<long> coalesced;
+  
+  // Constructor
+  PipelineCounters() : submitted(0), dropped(0), stale(0), coalesced(0) {}
+  
+};
+
+// Control thread of one event loop
+// The event loop decodes telemetry and submits it, the control thread runs the
+// controllers and tracing, and the event loop sends the resulting commands.
+// Both directions go through bounded single-producer/single-consumer rings,
+// so neither thread ever waits for the other.
+class ControlPipeline {
+  
+private:
+  
+  // Frames each ring holds, a power of two
+  static const size_t kCapacity = 1024;
+  
+  SpscRing<PipelineFrame, kCapacity> frames;
+  SpscRing<PipelineCommand, kCapacity> commands;
+  
+  // Trace written by the control thread
+  TraceWriter &trace;
+  
+  // Wakes the event loop after commands were added, called from the control thread
+  void (*wake)(void *data);
+  void *wake_data;
+  
+  // Only the newest frame of a session gets a command when set
+  bool coalescing;
+  
+  // Stage latency histograms, nullptr when stages are not timed
+  StageHistograms *histograms;
+  
+  PipelineCounters &counters;
+  
+  std::atomic<bool> running;
+  std::thread control;
+  
+  // Runs the controllers until the pipeline is stopped
+  void Run();
+  
+public:
+  
+  // Constructor
+  // When coalescing, stale frames update the PID errors and the newest frame of the
+  // session answers for all of them
+  // The control thread times its stages into histograms unless it is nullptr
+  ControlPipeline(TraceWriter &trace, void (*wake)(void *data), void *wake_data, bool coalescing,
+                  StageHistograms *histograms, PipelineCounters &counters);
+  
+  // Stops the control thread
+  ~ControlPipeline();
+  
+  ControlPipeline(const ControlPipeline &) = delete;
+  ControlPipeline &operator=(const ControlPipeline &) = delete;
+  
+  // Starts the control thread
+  void Start();
+  
+  // Stops the control thread, frames still in the rings are discarded
+  void Stop();
+  
+  // Hands a telemetry frame to the control thread, event loop only
+  // Returns false and counts the frame as dropped if the ring is full
+  bool Submit(Session *session, const Telemetry &telemetry);
+  
+  // Takes the next command computed by the control thread, event loop only
+  bool Receive(PipelineCommand &command);
+  
+  // Stage latency histograms shared by the event loop and the control thread
+  StageHistograms *Histograms() const;
+  
+  // Counters
+  long Submitted() const;
+  long Dropped() const;
+  long Stale() const;
+  long Coalesced() const;
+  
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,48 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Controller.h"
+
+struct SessionMetrics;
+
+// State of one connected simulator
+// Created when the simulator connects and attached to its WebSocket as user data,
+// so every simulator drives and tunes with its own controller
+struct Session {
+  
+  // Connection number, counted from 1
+  long id;
+  
+  // Steering and throttle controller of this simulator
+  // Only used by the thread running the controller, the event loop or its control thread
+  Controller controller;
+  
+  // Metrics slot of the session, nullptr if every slot is taken
+  // Published to by the thread running the controller
+  SessionMetrics *metrics;
+  
+  // Sequence number of the newest telemetry frame handed to the control thread
+  // Written by the event loop, read by the control thread to detect stale frames
+  std::atomic<uint64_t> received;
+  
+  // Frames coalesced into the next command, control thread only
+  int skipped;
+  
+  // Frames handed to the control thread whose command has not come back yet
+  // The session outlives its socket until this drops to 0
+  // Event loop only
+  int in_flight;
+  
+  // Set when the socket closed while frames were in flight
+  // Event loop only
+  bool closed;
+  
+  // Constructor
+  explicit Session(long id) : id(id), metrics(nullptr), received(0), skipped(0), in_flight(0), closed(false) {}
+  
+};
+
+#endif // SESSION_H
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Simulator.h"
+
+
+// Converts meters per second to MPH
+static const double kMetersPerSecondToMph = 2.23694;
+
+// Number of segments searched on each side of the last closest segment
+static const size_t kSearchWindow = 8;
+
+
+// Lake-like loop of about 1.1 km with curves of varying sharpness
+Track DefaultTrack() {
+  
+  Track track;
+  const int kWaypoints = 720;
+  
+  for (int n = 0; n < kWaypoints; ++n) {
+    
+    double angle = 2.0 * M_PI * n / kWaypoints;
+    double radius = 170.0 + 30.0 * std::cos(2.0 * angle) + 12.0 * std::sin(3.0 * angle);
+    
+    track.waypoints.push_back(Waypoint{radius * std::cos(angle), radius * std::sin(angle)});
+    
+  }
+  
+  return track;
+  
+}
+
+
+// Default parameters approximating the Unity simulator car
+VehicleModel DefaultVehicleModel() {
+  
+  VehicleModel model;
+  
+  model.wheelbase = 2.67;
+  model.max_steering_angle = 25.0;
+  model.max_acceleration = 5.0;
+  model.quadratic_drag = 0.0015;
+  model.linear_drag = 0.05;
+  model.dt = 0.05;
+  
+  return model;
+  
+}
+
+
+Simulator::Simulator(const Track &track, const VehicleModel &model) : track(track), model(model) {
+  
+  Reset();
+  
+}
+
+
+// Places the vehicle at rest at the start of the track
+void Simulator::Reset() {
+  
+  Reset(0);
+  
+}
+
+
+// Places the vehicle at rest on the given waypoint, facing along the track
+void Simulator::Reset(size_t waypoint) {
+  
+  const size_t n = track.waypoints.size();
+  
+  const Waypoint &start = track.waypoints[waypoint % n];
+  const Waypoint &next = track.waypoints[(waypoint + 1) % n];
+  
+  x = start.x;
+  y = start.y;
+  heading = std::atan2(next.y - start.y, next.x - start.x);
+  velocity = 0.0;
+  steering_angle = 0.0;
+  segment = waypoint % n;
+  
+  Localize();
+  
+}
+
+
+// Updates the closest segment and the cross track error
+// Only segments near the previous one are searched so each tick costs O(1)
+void Simulator::Localize() {
+  
+  const size_t n = track.waypoints.size();
+  
+  double best_distance = INFINITY;
+  size_t best_segment = segment;
+  
+  for (size_t offset = 0; offset <= 2 * kSearchWindow; ++offset) {
+    
+    size_t k = (segment + n - kSearchWindow + offset) % n;
+    
+    const Waypoint &a = track.waypoints[k];
+    const Waypoint &b = track.waypoints[(k + 1) % n];
+    
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double t = std::max(0.0, std::min(1.0, ((x - a.x) * dx + (y - a.y) * dy) / (dx * dx + dy * dy)));
+    
+    double px = x - (a.x + t * dx);
+    double py = y - (a.y + t * dy);
+    double distance = px * px + py * py;
+    
+    if (distance < best_distance) {
+      best_distance = distance;
+      best_segment = k;
+    }
+    
+  }
+  
+  segment = best_segment;
+  
+  // Signed distance to the closest segment, positive to the left of the driving direction
+  const Waypoint &a = track.waypoints[segment];
+  const Waypoint &b = track.waypoints[(segment + 1) % n];
+  
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  
+  cte = ((x - a.x) * -dy + (y - a.y) * dx) / std::sqrt(dx * dx + dy * dy);
+  
+}
+
+
+// Telemetry for the current state
+Telemetry Simulator::Observe() const {
+  
+  Telemetry telemetry;
+  
+  telemetry.cte = cte;
+  telemetry.speed = velocity * kMetersPerSecondToMph;
+  telemetry.steering_angle = steering_angle;
+  
+  return telemetry;
+  
+}
+
+
+// Applies the steering and throttle values for one tick
+Telemetry Simulator::Step(double steering, double throttle) {
+  
+  steering = std::max(-1.0, std::min(1.0, steering));
+  throttle = std::max(-1.0, std::min(1.0, throttle));
+  
+  steering_angle = steering * model.max_steering_angle;
+  
+  // Kinematic bicycle model
+  double delta = steering_angle * M_PI / 180.0;
+  
+  x += velocity * std::cos(heading) * model.dt;
+  y += velocity * std::sin(heading) * model.dt;
+  heading += velocity / model.wheelbase * std::tan(delta) * model.dt;
+  
+  double acceleration = throttle * model.max_acceleration -
+                        model.quadratic_drag * velocity * velocity - model.linear_drag * velocity;
+  
+  velocity = std::max(0.0, velocity + acceleration * model.dt);
+  
+  Localize();
+  
+  return Observe();
+  
+}
+
+
+// Number of waypoints of the track
+size_t Simulator::TrackSize() const {
+  
+  return track.waypoints.size();
+  
+}
+
+
+// Time between ticks in seconds
+double Simulator::TickSeconds() const {
+  
+  return model.dt;
+  
+}
+
+
+// Drives the controller on the simulator for the given number of ticks
+DriveStatistics Drive(Simulator &simulator, Controller &controller, long ticks) {
+  
+  DriveStatistics statistics = {0, 0};
+  Telemetry telemetry = simulator.Observe();
+  
+  for (long n = 0; n < ticks; ++n) {
+    
+    ControlCommand command = controller.Step(telemetry);
+    
+    if (command.action == ControlAction::kReset) {
+      simulator.Reset();
+      telemetry = simulator.Observe();
+      statistics.resets += 1;
+    }
+    
+    else {
+      telemetry = simulator.Step(command.steering_angle, command.throttle);
+    }
+    
+    statistics.ticks += 1;
+    
+  }
+  
+  return statistics;
+  
+}
@@ -0,0 +1,115 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Controller.h"
+#include "Telemetry.h"
+
+// Point on the track center line in meters
+struct Waypoint {
+  
+  double x;
+  double y;
+  
+};
+
+// Closed track defined by its center line
+struct Track {
+  
+  std::vector<Waypoint> waypoints;
+  
+};
+
+// Lake-like loop of about 1.1 km with curves of varying sharpness
+Track DefaultTrack();
+
+// Vehicle parameters of the headless simulator
+struct VehicleModel {
+  
+  // Distance between the axles in meters
+  double wheelbase;
+  
+  // Steering angle in degrees for a normalized steering value of 1
+  double max_steering_angle;
+  
+  // Acceleration in m/s^2 at full throttle
+  double max_acceleration;
+  
+  // Aerodynamic and rolling drag coefficients
+  double quadratic_drag;
+  double linear_drag;
+  
+  // Time between telemetry ticks in seconds
+  double dt;
+  
+};
+
+// Default parameters approximating the Unity simulator car
+VehicleModel DefaultVehicleModel();
+
+// Headless kinematic bicycle model simulator
+// Produces the same telemetry as the Unity simulator's telemetry event
+// Positive steering values increase the cross track error, as in the simulator
+class Simulator {
+  
+private:
+  
+  Track track;
+  VehicleModel model;
+  
+  // Vehicle state
+  double x;
+  double y;
+  double heading;
+  double velocity;
+  double steering_angle;
+  
+  // Index of the track segment closest to the vehicle
+  size_t segment;
+  
+  // Cross track error of the current position
+  double cte;
+  
+  // Updates the closest segment and the cross track error
+  void Localize();
+  
+public:
+  
+  Simulator(const Track &track, const VehicleModel &model);
+  
+  // Places the vehicle at rest at the start of the track
+  void Reset();
+  
+  // Places the vehicle at rest on the given waypoint, facing along the track
+  void Reset(size_t waypoint);
+  
+  // Number of waypoints of the track
+  size_t TrackSize() const;
+  
+  // Telemetry for the current state
+  Telemetry Observe() const;
+  
+  // Applies the steering and throttle values for one tick
+  // Both are clamped to [-1, 1] as in the Unity simulator
+  Telemetry Step(double steering, double throttle);
+  
+  // Time between ticks in seconds
+  double TickSeconds() const;
+  
+};
+
+// Counters of a headless drive
+struct DriveStatistics {
+  
+  long ticks;
+  long resets;
+  
+};
+
+// Drives the controller on the simulator for the given number of ticks
+// Handles reset commands the way the Unity simulator does
+DriveStatistics Drive(Simulator &simulator, Controller &controller, long ticks);
+
+#endif // SIMULATOR_H
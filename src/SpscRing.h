@@ -0,0 +1,108 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring buffer for one producer thread and one consumer thread
+// Capacity must be a power of two
+// Each side keeps a cached copy of the other side's position, so the shared
+// cache lines are only read when the ring looks full or empty
+template <typename T, size_t Capacity>
+class SpscRing {
+  
+private:
+  
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  
+  static const size_t kMask = Capacity - 1;
+  
+  // Producer position and its copy of the consumer position
+  alignas(64) std::atomic<size_t> write_position;
+  size_t cached_read_position;
+  
+  // Consumer position and its copy of the producer position
+  alignas(64) std::atomic<size_t> read_position;
+  size_t cached_write_position;
+  
+  alignas(64) T slots[Capacity];
+  
+public:
+  
+  // Constructor
+  SpscRing() : write_position(0), cached_read_position(0), read_position(0), cached_write_position(0) {}
+  
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+  
+  // Adds a value, producer thread only
+  // Returns false without blocking if the ring is full
+  bool Push(const T &value);
+  
+  // Takes the oldest value, consumer thread only
+  // Returns false without blocking if the ring is empty
+  bool Pop(T &value);
+  
+  // Number of values in the ring, exact only on the consumer thread while the producer is idle
+  size_t Size() const;
+  
+};
+
+
+// Adds a value, producer thread only
+template <typename T, size_t Capacity>
+bool SpscRing<T, Capacity>::Push(const T &value) {
+  
+  size_t position = write_position.load(std::memory_order_relaxed);
+  
+  if (position - cached_read_position == Capacity) {
+    
+    cached_read_position = read_position.load(std::memory_order_acquire);
+    
+    if (position - cached_read_position == Capacity) {
+      return false;
+    }
+    
+  }
+  
+  slots[position & kMask] = value;
+  write_position.store(position + 1, std::memory_order_release);
+  
+  return true;
+  
+}
+
+
+// Takes the oldest value, consumer thread only
+template <typename T, size_t Capacity>
+bool SpscRing<T, Capacity>::Pop(T &value) {
+  
+  size_t position = read_position.load(std::memory_order_relaxed);
+  
+  if (position == cached_write_position) {
+    
+    cached_write_position = write_position.load(std::memory_order_acquire);
+    
+    if (position == cached_write_position) {
+      return false;
+    }
+    
+  }
+  
+  value = slots[position & kMask];
+  read_position.store(position + 1, std::memory_order_release);
+  
+  return true;
+  
+}
+
+
+// Number of values in the ring
+template <typename T, size_t Capacity>
+size_t SpscRing<T, Capacity>::Size() const {
+  
+  return write_position.load(std::memory_order_acquire) - read_position.load(std::memory_order_acquire);
+  
+}
+
+#endif // SPSC_RING_H
@@ -0,0 +1,122 @@
+#ifndef STAGE_TIMER_H
+#define STAGE_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+// Stages of the control loop
+enum Stage : int {
+  kStageFrameScan,
+  kStageParse,
+  kStagePidUpdate,
+  kStageTwiddle,
+  kStageLogging,
+  kStageSerialization,
+  kStageSend,
+  kStageCount
+};
+
+// Name of a stage for reports
+inline const char *StageName(int stage) {
+  
+  static const char *const kNames[kStageCount] = {
+    "frame_scan", "parse", "pid_update", "twiddle", "logging", "serialization", "send"
+  };
+  
+  return kNames[stage];
+  
+}
+
+// Latency histograms of every stage
+struct StageHistograms {
+  
+  LatencyHistogram stages[kStageCount];
+  
+};
+
+// Times the stages of one tick in every kSampleInterval ticks of a thread
+// Each Lap reads the monotonic clock once and charges the time since the previous lap to
+// a stage; Finish records one sample per stage touched during the tick.
+// A timer without histograms, or of a tick that is not sampled, does nothing, so instrumented
+// code costs one branch on the other ticks.
+class StageTimer {
+  
+private:
+  
+  StageHistograms *histograms;
+  
+  uint64_t last;
+  uint64_t elapsed[kStageCount];
+  unsigned touched;
+  
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  
+  // True for the first of every kSampleInterval ticks started on the calling thread
+  static bool Sampled() {
+    static thread_local unsigned ticks = 0;
+    return ticks++ % kSampleInterval == 0;
+  }
+  
+public:
+  
+  // Ticks per timed tick
+  // Timing every tick reads the clock about 8 times per message, which costs several hundred
+  // nanoseconds, more than the stages it measures
+  static const unsigned kSampleInterval = 16;
+  
+  // Starts timing a tick if it is sampled
+  explicit StageTimer(StageHistograms *histograms)
+    : histograms(histograms != nullptr && Sampled() ? histograms : nullptr), touched(0) {
+    if (histograms != nullptr) {
+      last = Now();
+    }
+  }
+  
+  // Charges the time since the previous lap to the stage
+  void Lap(int stage) {
+    
+    if (histograms == nullptr) {
+      return;
+    }
+    
+    uint64_t now = Now();
+    
+    if (touched & (1u << stage)) {
+      elapsed[stage] += now - last;
+    }
+    
+    else {
+      elapsed[stage] = now - last;
+      touched |= 1u << stage;
+    }
+    
+    last = now;
+    
+  }
+  
+  // Skips the time since the previous lap
+  void Restart() {
+    if (histograms != nullptr) {
+      last = Now();
+    }
+  }
+  
+  // Records the stages of the tick
+  void Finish() {
+    
+    for (int stage = 0; touched != 0; ++stage, touched >>= 1) {
+      if (touched & 1u) {
+        histograms->stages[stage].Record(elapsed[stage]);
+      }
+    }
+    
+  }
+  
+};
+
+#endif // STAGE_TIMER_H
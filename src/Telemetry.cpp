@@ -0,0 +1,276 @@
+#include <cstring>
+
+#include "Numbers.h"
+#include "Telemetry.h"
+
+
+// Skips JSON whitespace
+static const char *SkipWhitespace(const char *c, const char *end) {
+  
+  while (c != end && (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')) {
+    ++c;
+  }
+  
+  return c;
+  
+}
+
+
+// Skips a JSON string starting at its opening quote
+// Returns the position after the closing quote or nullptr if it is unterminated
+static const char *SkipString(const char *c, const char *end) {
+  
+  ++c;
+  
+  while (c != end) {
+    
+    // Jumping to the next quote instead of inspecting every byte of long values
+    const char *quote = static_cast<const char *>(memchr(c, '"', end - c));
+    
+    if (quote == nullptr) {
+      return nullptr;
+    }
+    
+    // The quote is escaped if it is preceded by an odd number of backslashes
+    size_t backslashes = 0;
+    
+    while (quote - backslashes > c && quote[-1 - static_cast<ptrdiff_t>(backslashes)] == '\\') {
+      ++backslashes;
+    }
+    
+    if (backslashes % 2 == 0) {
+      return quote + 1;
+    }
+    
+    c = quote + 1;
+    
+  }
+  
+  return nullptr;
+  
+}
+
+
+// Skips any JSON value without materializing it
+// Returns the position after the value or nullptr if it is malformed
+static const char *SkipValue(const char *c, const char *end) {
+  
+  if (c == end) {
+    return nullptr;
+  }
+  
+  if (*c == '"') {
+    return SkipString(c, end);
+  }
+  
+  // Skipping nested objects and arrays by tracking their depth
+  if (*c == '{' || *c == '[') {
+    
+    int depth = 0;
+    
+    while (c != end) {
+      
+      if (*c == '"') {
+        
+        c = SkipString(c, end);
+        
+        if (c == nullptr) {
+          return nullptr;
+        }
+        
+        continue;
+        
+      }
+      
+      if (*c == '{' || *c == '[') {
+        ++depth;
+      }
+      
+      else if (*c == '}' || *c == ']') {
+        
+        if (--depth == 0) {
+          return c + 1;
+        }
+        
+      }
+      
+      ++c;
+      
+    }
+    
+    return nullptr;
+    
+  }
+  
+  // Numbers, true, false and null end at the next delimiter
+  while (c != end && *c != ',' && *c != '}' && *c != ']' &&
+         *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r') {
+    ++c;
+  }
+  
+  return c;
+  
+}
+
+
+// Converts a quoted or bare number value to a double
+// Returns the position after the value or nullptr if it is not a number
+static const char *ParseNumber(const char *c, const char *end, double &value) {
+  
+  bool quoted = *c == '"';
+  
+  if (quoted) {
+    ++c;
+  }
+  
+  c = ParseDouble(c, end, value);
+  
+  if (c == nullptr) {
+    return nullptr;
+  }
+  
+  if (quoted) {
+    return c != end && *c == '"' ? c + 1 : nullptr;
+  }
+  
+  return c;
+  
+}
+
+
+// Telemetry fields read by the decoder
+enum TelemetryField {
+  kCte = 1,
+  kSpeed = 2,
+  kSteeringAngle = 4,
+  kAllFields = kCte | kSpeed | kSteeringAngle
+};
+
+
+// Matches an object key against the telemetry fields
+static int MatchField(const char *key, size_t length) {
+  
+  switch (length) {
+      
+    case 3: {
+      return memcmp(key, "cte", 3) == 0 ? kCte : 0;
+    }
+      
+    case 5: {
+      return memcmp(key, "speed", 5) == 0 ? kSpeed : 0;
+    }
+      
+    case 14: {
+      return memcmp(key, "steering_angle", 14) == 0 ? kSteeringAngle : 0;
+    }
+      
+  } // End switch
+  
+  return 0;
+  
+}
+
+
+// Extracts the telemetry values from a ["telemetry",{...}] payload
+// Decodes the payload in a single forward pass and skips all other fields
+bool ParseTelemetry(const char *payload, size_t length, Telemetry &telemetry) {
+  
+  static const char kEvent[] = "\"telemetry\"";
+  static const size_t kEventLength = sizeof(kEvent) - 1;
+  
+  const char *end = payload + length;
+  
+  if (length == 0 || payload[0] != '[') {
+    return false;
+  }
+  
+  const char *c = SkipWhitespace(payload + 1, end);
+  
+  // Checking the event name
+  if (end - c < static_cast<ptrdiff_t>(kEventLength) || memcmp(c, kEvent, kEventLength) != 0) {
+    return false;
+  }
+  
+  c = SkipWhitespace(c + kEventLength, end);
+  
+  if (c == end || *c != ',') {
+    return false;
+  }
+  
+  c = SkipWhitespace(c + 1, end);
+  
+  if (c == end || *c != '{') {
+    return false;
+  }
+  
+  int found = 0;
+  
+  // Walking the key/value pairs of the data object
+  for (c = SkipWhitespace(c + 1, end); c != end && *c != '}'; c = SkipWhitespace(c, end)) {
+    
+    if (*c != '"') {
+      return false;
+    }
+    
+    const char *key = c + 1;
+    c = SkipString(c, end);
+    
+    if (c == nullptr) {
+      return false;
+    }
+    
+    int field = MatchField(key, c - key - 1);
+    
+    c = SkipWhitespace(c, end);
+    
+    if (c == end || *c != ':') {
+      return false;
+    }
+    
+    c = SkipWhitespace(c + 1, end);
+    
+    if (c == end) {
+      return false;
+    }
+    
+    switch (field) {
+        
+      case kCte: {
+        c = ParseNumber(c, end, telemetry.cte);
+        break;
+      }
+        
+      case kSpeed: {
+        c = ParseNumber(c, end, telemetry.speed);
+        break;
+      }
+        
+      case kSteeringAngle: {
+        c = ParseNumber(c, end, telemetry.steering_angle);
+        break;
+      }
+        
+      default: {
+        c = SkipValue(c, end);
+        break;
+      }
+        
+    } // End switch
+    
+    if (c == nullptr) {
+      return false;
+    }
+    
+    found |= field;
+    
+    c = SkipWhitespace(c, end);
+    
+    if (c != end && *c == ',') {
+      ++c;
+    }
+    
+  }
+  
+  return found == kAllFields;
+  
+}
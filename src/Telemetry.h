@@ -0,0 +1,25 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstddef>
+
+// Telemetry values sent by the simulator
+struct Telemetry {
+  
+  // Cross track error
+  double cte;
+  
+  // Speed in MPH
+  double speed;
+  
+  // Steering angle in degrees
+  double steering_angle;
+  
+};
+
+// Extracts the telemetry values from a ["telemetry",{...}] payload
+// Other fields, such as the camera image, are skipped without being copied
+// Returns false if the payload is not a telemetry event or a value is missing
+bool ParseTelemetry(const char *payload, size_t length, Telemetry &telemetry);
+
+#endif // TELEMETRY_H
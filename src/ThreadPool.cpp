@@ -0,0 +1,205 @@
+#include "ThreadPool.h"
+
+
+// Pool and deque of the current thread, set for the worker threads
+static thread_local ThreadPool *current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+
+// Constructor
+ThreadPool::ThreadPool(int threads) : queued(0), pending(0), steals(0), next_queue(0), stopping(false) {
+  
+  size_t size = threads > 1 ? threads : 1;
+  
+  for (size_t n = 0; n < size; ++n) {
+    queues.emplace_back(new Queue());
+  }
+  
+  for (size_t n = 1; n < size; ++n) {
+    workers.emplace_back(&ThreadPool::Work, this, n);
+  }
+  
+}
+
+
+// Finishes the queued tasks and stops the worker threads
+ThreadPool::~ThreadPool() {
+  
+  Wait();
+  
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    stopping = true;
+  }
+  
+  wake.notify_all();
+  
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  
+}
+
+
+// Number of participants, including the thread calling Wait
+int ThreadPool::Size() const {
+  
+  return int(queues.size());
+  
+}
+
+
+// Number of tasks stolen from another deque so far
+long ThreadPool::Steals() const {
+  
+  return steals.load(std::memory_order_relaxed);
+  
+}
+
+
+// Queues a task
+void ThreadPool::Submit(std::function<void()> task) {
+  
+  // Spreading tasks submitted from outside the pool over all deques
+  size_t queue = current_pool == this ? current_queue
+                                      : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+  
+  pending.fetch_add(1);
+  
+  {
+    std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+    queues[queue]->tasks.push_back(std::move(task));
+  }
+  
+  queued.fetch_add(1);
+  
+  // Taking the sleep mutex so that a worker checking queued cannot miss the notification
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+  }
+  
+  wake.notify_one();
+  
+}
+
+
+// Takes a task, own deque first, then the other deques
+bool ThreadPool::Take(size_t queue, std::function<void()> &task) {
+  
+  // Newest own task, while its data is still in cache
+  {
+    std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+    
+    if (!queues[queue]->tasks.empty()) {
+      task = std::move(queues[queue]->tasks.back());
+      queues[queue]->tasks.pop_back();
+      return true;
+    }
+  }
+  
+  // Oldest task of another deque, which is the largest remaining piece of work
+  for (size_t offset = 1; offset < queues.size(); ++offset) {
+    
+    Queue &victim = *queues[(queue + offset) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    
+  }
+  
+  return false;
+  
+}
+
+
+// Runs a task taken from a deque
+void ThreadPool::Run(std::function<void()> &task) {
+  
+  queued.fetch_sub(1);
+  task();
+  task = nullptr;
+  
+  // Waking Wait once the last task has finished
+  if (pending.fetch_sub(1) == 1) {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    done.notify_all();
+  }
+  
+}
+
+
+// Worker thread loop
+void ThreadPool::Work(size_t queue) {
+  
+  current_pool = this;
+  current_queue = queue;
+  
+  std::function<void()> task;
+  
+  while (true) {
+    
+    if (Take(queue, task)) {
+      Run(task);
+      continue;
+    }
+    
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+    
+    if (stopping && queued.load() == 0) {
+      return;
+    }
+    
+  }
+  
+}
+
+
+// Runs tasks on the calling thread until every submitted task has finished
+void ThreadPool::Wait() {
+  
+  ThreadPool *previous_pool = current_pool;
+  size_t previous_queue = current_queue;
+  
+  // Tasks submitted while helping go to deque 0 unless the caller is a worker of this pool
+  if (current_pool != this) {
+    current_pool = this;
+    current_queue = 0;
+  }
+  
+  std::function<void()> task;
+  
+  while (pending.load() > 0) {
+    
+    if (Take(current_queue, task)) {
+      Run(task);
+      continue;
+    }
+    
+    // Remaining tasks are running on the workers
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    done.wait(lock, [this]() { return pending.load() == 0 || queued.load() > 0; });
+    
+  }
+  
+  current_pool = previous_pool;
+  current_queue = previous_queue;
+  
+}
+
+
+// Runs function(0) to function(count - 1) as separate tasks and waits for them
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &function) {
+  
+  for (size_t n = 0; n < count; ++n) {
+    Submit([&function, n]() { function(n); });
+  }
+  
+  Wait();
+  
+}
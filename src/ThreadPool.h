@@ -0,0 +1,91 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for tuning and evaluation jobs
+// Each participant owns a deque of tasks. A participant runs its own tasks newest first
+// and, once its deque is empty, steals the oldest task of another deque, so short and
+// long tasks even out across threads without any static partitioning.
+// A pool of n threads runs n - 1 worker threads; the thread calling Wait is the n-th
+// participant and owns deque 0.
+class ThreadPool {
+  
+private:
+  
+  // Tasks of one participant, guarded by its own mutex
+  struct Queue {
+    
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    
+  };
+  
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  
+  // Tasks sitting in a deque, and tasks submitted but not finished
+  std::atomic<long> queued;
+  std::atomic<long> pending;
+  
+  // Tasks taken from another participant's deque
+  std::atomic<long> steals;
+  
+  // Deque of the next task submitted from outside the pool
+  std::atomic<size_t> next_queue;
+  
+  // Sleeping workers wait on wake, Wait waits on done
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool stopping;
+  
+  // Takes a task, own deque first, then the other deques
+  bool Take(size_t queue, std::function<void()> &task);
+  
+  // Runs a task taken from a deque
+  void Run(std::function<void()> &task);
+  
+  // Worker thread loop
+  void Work(size_t queue);
+  
+public:
+  
+  // Constructor
+  // Starts threads - 1 worker threads
+  explicit ThreadPool(int threads);
+  
+  // Finishes the queued tasks and stops the worker threads
+  ~ThreadPool();
+  
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  
+  // Number of participants, including the thread calling Wait
+  int Size() const;
+  
+  // Queues a task
+  // Tasks submitted by a task go to the deque of the thread running it
+  void Submit(std::function<void()> task);
+  
+  // Runs tasks on the calling thread until every submitted task has finished
+  // Must not be called from a task
+  void Wait();
+  
+  // Runs function(0) to function(count - 1) as separate tasks and waits for them
+  void ParallelFor(size_t count, const std::function<void(size_t)> &function);
+  
+  // Number of tasks stolen from another deque so far
+  long Steals() const;
+  
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,273 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Trace.h"
+
+
+// The chunks are mapped at file offsets that are multiples of their size, which must be page aligned
+static_assert(TraceWriter::kChunkBytes % 65536 == 0, "Trace chunks are not page aligned");
+
+
+TraceWriter::TraceWriter()
+  : file(-1), mapping(nullptr), mapped(0), capacity(0), grow_at(0), header(nullptr), records(nullptr),
+    grow_requested(false), grow_failed(false), stopping(false) {}
+
+
+TraceWriter::~TraceWriter() {
+  
+  Close();
+  
+}
+
+
+// Creates the trace file
+bool TraceWriter::Open(const std::string &path) {
+  
+  Close();
+  
+  file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  
+  if (file < 0) {
+    return false;
+  }
+  
+  // Reserving address space only, chunks of the file are mapped over it as it grows
+  void *address = mmap(nullptr, kReservedBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  
+  if (address == MAP_FAILED) {
+    Close();
+    return false;
+  }
+  
+  mapping = static_cast<char *>(address);
+  header = reinterpret_cast<TraceHeader *>(mapping);
+  records = reinterpret_cast<TraceRecord *>(mapping + sizeof(TraceHeader));
+  
+  if (!Grow()) {
+    Close();
+    return false;
+  }
+  
+  memcpy(header->magic, kTraceMagic, sizeof(kTraceMagic));
+  header->version = kTraceVersion;
+  header->record_size = sizeof(TraceRecord);
+  header->record_count = 0;
+  
+  grow_at = capacity - kChunkRecords / 2;
+  grow_requested = false;
+  grow_failed = false;
+  stopping = false;
+  grower = std::thread(&TraceWriter::RunGrower, this);
+  
+  // Growing only when the CPU is otherwise idle, so that waking the grower never preempts the
+  // thread appending records. If that thread keeps the CPU busy, it waits for the grower when full.
+  sched_param parameters = {};
+  pthread_setschedparam(grower.native_handle(), SCHED_IDLE, &parameters);
+  
+  return true;
+  
+}
+
+
+// Allocates the next chunk of the file and maps it after the mapped bytes
+bool TraceWriter::Grow() {
+  
+  if (mapped + kChunkBytes > kReservedBytes) {
+    return false;
+  }
+  
+  // Allocating the blocks, so that the file is not sparse and stores to the mapping cannot fail
+  // on a full disk. File systems without fallocate support get a sparse file instead.
+  int result = posix_fallocate(file, mapped, kChunkBytes);
+  
+  if (result == ENOSPC || (result != 0 && ftruncate(file, mapped + kChunkBytes) != 0)) {
+    return false;
+  }
+  
+  char *chunk = mapping + mapped;
+  
+  if (mmap(chunk, kChunkBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file, mapped) == MAP_FAILED) {
+    return false;
+  }
+  
+  // Faulting the pages in now rather than on the appends that first write them
+  // Records are only stored here once capacity covers them, so the chunk is still unused
+  long page = sysconf(_SC_PAGESIZE);
+  
+  for (size_t offset = 0; offset < kChunkBytes; offset += page) {
+    *reinterpret_cast<volatile char *>(chunk + offset) = 0;
+  }
+  
+  mapped += kChunkBytes;
+  capacity.store((mapped - sizeof(TraceHeader)) / sizeof(TraceRecord), std::memory_order_release);
+  
+  return true;
+  
+}
+
+
+// Grows the file on request until the writer is closed
+void TraceWriter::RunGrower() {
+  
+  std::unique_lock<std::mutex> lock(mutex);
+  
+  while (true) {
+    
+    changed.wait(lock, [this] { return grow_requested || stopping; });
+    
+    if (stopping) {
+      return;
+    }
+    
+    grow_requested = false;
+    
+    lock.unlock();
+    bool grown = Grow();
+    lock.lock();
+    
+    grow_failed = !grown;
+    changed.notify_all();
+    
+  }
+  
+}
+
+
+// Waits for the grower thread to map more records than count
+bool TraceWriter::WaitForCapacity(size_t count) {
+  
+  std::unique_lock<std::mutex> lock(mutex);
+  
+  changed.wait(lock, [this, count] {
+    return grow_failed || capacity.load(std::memory_order_acquire) > count;
+  });
+  
+  return capacity.load(std::memory_order_acquire) > count;
+  
+}
+
+
+// Appends one record
+bool TraceWriter::Append(const TraceRecord &record) {
+  
+  if (mapping == nullptr) {
+    return false;
+  }
+  
+  size_t count = header->record_count;
+  
+  // Requesting the next chunk while half of the current one is left
+  if (count == grow_at) {
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    grow_requested = true;
+    grow_at += kChunkRecords;
+    changed.notify_all();
+    
+  }
+  
+  if (count >= capacity.load(std::memory_order_acquire) && !WaitForCapacity(count)) {
+    Close();
+    return false;
+  }
+  
+  records[count] = record;
+  header->record_count = count + 1;
+  
+  return true;
+  
+}
+
+
+// Truncates the file to the records written and closes it
+void TraceWriter::Close() {
+  
+  if (grower.joinable()) {
+    
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      changed.notify_all();
+    }
+    
+    grower.join();
+    
+  }
+  
+  if (file < 0) {
+    return;
+  }
+  
+  size_t size = 0;
+  
+  if (mapped != 0) {
+    size = sizeof(TraceHeader) + header->record_count * sizeof(TraceRecord);
+  }
+  
+  if (mapping != nullptr) {
+    munmap(mapping, kReservedBytes);
+  }
+  
+  // The header still holds the record count if truncating fails
+  int result = ftruncate(file, size);
+  (void) result;
+  
+  close(file);
+  file = -1;
+  mapping = nullptr;
+  mapped = 0;
+  capacity = 0;
+  header = nullptr;
+  records = nullptr;
+  
+}
+
+
+bool TraceWriter::IsOpen() const {
+  
+  return mapping != nullptr;
+  
+}
+
+
+// Reads all records of a trace file
+bool ReadTrace(const std::string &path, std::vector<TraceRecord> &records) {
+  
+  FILE *file = fopen(path.c_str(), "rb");
+  
+  if (file == nullptr) {
+    return false;
+  }
+  
+  TraceHeader header;
+  
+  bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+               memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) == 0 &&
+               header.version == kTraceVersion && header.record_size == sizeof(TraceRecord);
+  
+  if (valid) {
+    records.resize(header.record_count);
+    valid = fread(records.data(), sizeof(TraceRecord), records.size(), file) == records.size();
+  }
+  
+  fclose(file);
+  
+  return valid;
+  
+}
+
+
+// Current steady clock time in nanoseconds
+uint64_t TraceTimestamp() {
+  
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+  
+}
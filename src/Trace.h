@@ -0,0 +1,157 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Flight trace file layout
+// A TraceHeader followed by record_count TraceRecords, all little endian
+
+const char kTraceMagic[8] = {'P', 'I', 'D', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t kTraceVersion = 1;
+
+struct TraceHeader {
+  
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  
+  // Updated after every record so that a crashed session leaves a readable file
+  uint64_t record_count;
+  
+};
+
+// Flags describing what happened on a tick
+enum TraceFlags : uint32_t {
+  kTraceOptimizing = 1,
+  kTraceReset = 2,
+  kTraceTwiddle = 4
+};
+
+// One record per telemetry tick
+struct TraceRecord {
+  
+  // Steady clock time in nanoseconds
+  uint64_t timestamp;
+  
+  // Telemetry
+  double cte;
+  double speed;
+  double angle;
+  
+  // Controller outputs
+  double steer;
+  double throttle;
+  
+  // Steering PID gains
+  double gains[3];
+  
+  // Accumulated mean squared errors
+  double best_error;
+  double current_error;
+  
+  // Twiddle state
+  int32_t index;
+  int32_t order;
+  
+  uint32_t flags;
+  
+  // Id of the simulator session the tick belongs to, counted from 1
+  // Traces written before sessions existed hold 0
+  uint32_t session;
+  
+};
+
+static_assert(sizeof(TraceHeader) == 24, "TraceHeader layout changed");
+static_assert(sizeof(TraceRecord) == 104, "TraceRecord layout changed");
+
+// Appends trace records to a memory mapped, preallocated file
+// The mapping lives in an address range reserved up front, so growing it never moves the records.
+// A background thread allocates and maps the next chunk when half of the current one is left,
+// so appending only stores the record.
+class TraceWriter {
+  
+private:
+  
+  int file;
+  
+  // Start of the reserved address range, the file is mapped at its beginning
+  char *mapping;
+  
+  // Bytes of the file mapped, only changed by the grower thread once it has started
+  size_t mapped;
+  
+  // Number of records the mapped file can hold
+  std::atomic<size_t> capacity;
+  
+  // Record count at which the next chunk is requested
+  size_t grow_at;
+  
+  TraceHeader *header;
+  TraceRecord *records;
+  
+  // Requests from the appending thread and results of the grower thread
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool grow_requested;
+  bool grow_failed;
+  bool stopping;
+  
+  std::thread grower;
+  
+  // Allocates the next chunk of the file and maps it after the mapped bytes
+  bool Grow();
+  
+  // Grows the file on request until the writer is closed
+  void RunGrower();
+  
+  // Waits for the grower thread to map more records than count
+  // Returns false if growing failed
+  bool WaitForCapacity(size_t count);
+  
+public:
+  
+  // Records preallocated at a time
+  static const size_t kChunkRecords = 65536;
+  
+  // Bytes preallocated at a time, a whole number of pages
+  static const size_t kChunkBytes = kChunkRecords * sizeof(TraceRecord);
+  
+  // Address space reserved for the mapping, which bounds the file to 64 GiB
+  static const size_t kReservedBytes = size_t(1) << 36;
+  
+  TraceWriter();
+  
+  ~TraceWriter();
+  
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+  
+  // Creates the trace file
+  bool Open(const std::string &path);
+  
+  // Appends one record
+  // Only waits for the grower thread if the file filled up before it mapped the next chunk
+  bool Append(const TraceRecord &record);
+  
+  // Truncates the file to the records written and closes it
+  void Close();
+  
+  bool IsOpen() const;
+  
+};
+
+// Reads all records of a trace file
+// Returns false if the file is missing, not a trace or truncated
+bool ReadTrace(const std::string &path, std::vector<TraceRecord> &records);
+
+// Current steady clock time in nanoseconds
+uint64_t TraceTimestamp();
+
+#endif // TRACE_H
@@ -0,0 +1,292 @@
+#include <math.h>
+
+#include "Controller.h"
+#include "Optimizer.h"
+#include "Tuning.h"
+
+
+// Index of the integral gain, which twiddle does not tune
+static const size_t kIntegralGain = 1;
+
+
+// Default episode: four starts of 2000 ticks
+EpisodeSettings DefaultEpisodeSettings() {
+  
+  EpisodeSettings settings;
+  
+  settings.ticks = 2000;
+  settings.starts = 4;
+  
+  return settings;
+  
+}
+
+
+// Drives one start of an episode with fixed steering gains and returns its sum of squared cross track errors
+// Steers with the application's controller in fixed gain mode
+static double RunStart(const Track &track, const VehicleModel &model,
+                       const Gains &gains, const EpisodeSettings &settings, int start) {
+  
+  Controller controller;
+  controller.logging = false;
+  controller.pid_steering.gains = gains;
+  controller.Restart();
+  
+  Simulator simulator(track, model);
+  simulator.Reset(start * simulator.TrackSize() / settings.starts);
+  Telemetry telemetry = simulator.Observe();
+  
+  double sum_squared_error = 0.0;
+  
+  for (int tick = 1; tick <= settings.ticks; ++tick) {
+    
+    sum_squared_error += telemetry.cte * telemetry.cte;
+    
+    ControlCommand command = controller.StepFixedGains(telemetry);
+    
+    // Ending the start with the largest allowed error on each remaining tick if the car
+    // drives off the track or gets stuck
+    if (command.action == ControlAction::kReset) {
+      sum_squared_error += (settings.ticks - tick) * kMaxCte * kMaxCte;
+      break;
+    }
+    
+    telemetry = simulator.Step(command.steering_angle, command.throttle);
+    
+  }
+  
+  return sum_squared_error;
+  
+}
+
+
+// Mean squared cross track error of an episode from the sums of its starts
+static double EpisodeError(const double *start_errors, const EpisodeSettings &settings) {
+  
+  double sum_squared_error = 0.0;
+  
+  for (int start = 0; start < settings.starts; ++start) {
+    sum_squared_error += start_errors[start];
+  }
+  
+  return sum_squared_error / (double(settings.ticks) * settings.starts);
+  
+}
+
+
+// Drives one episode with fixed steering gains and returns the mean squared cross track error
+double RunEpisode(const Track &track, const VehicleModel &model,
+                  const Gains &gains, const EpisodeSettings &settings) {
+  
+  std::vector<double> start_errors(settings.starts);
+  
+  for (int start = 0; start < settings.starts; ++start) {
+    start_errors[start] = RunStart(track, model, gains, settings, start);
+  }
+  
+  return EpisodeError(start_errors.data(), settings);
+  
+}
+
+
+// Scores each candidate like RunEpisode, one task per candidate and start on the thread pool
+void RunEpisodes(const Track &track, const VehicleModel &model,
+                 const std::vector<Gains> &candidates, const EpisodeSettings &settings,
+                 ThreadPool &pool, std::vector<double> &errors) {
+  
+  const size_t starts = settings.starts;
+  
+  std::vector<double> start_errors(candidates.size() * starts);
+  
+  pool.ParallelFor(start_errors.size(), [&](size_t task) {
+    start_errors[task] = RunStart(track, model, candidates[task / starts], settings, int(task % starts));
+  });
+  
+  errors.resize(candidates.size());
+  
+  for (size_t k = 0; k < candidates.size(); ++k) {
+    errors[k] = EpisodeError(&start_errors[k * starts], settings);
+  }
+  
+}
+
+
+// Tunes the steering gains with PDController::Twiddle, one episode at a time
+TuningResult TwiddleSequential(const Track &track, const VehicleModel &model,
+                               const EpisodeSettings &settings, long max_episodes) {
+  
+  Controller controller;
+  PDController pid_steering = controller.pid_steering;
+  
+  TuningResult result;
+  result.gains = pid_steering.gains;
+  result.best_error = INFINITY;
+  result.episodes = 0;
+  result.rounds = 0;
+  
+  while (pid_steering.CalculateSum() > kTuningThreshold && result.episodes < max_episodes) {
+    
+    double error = RunEpisode(track, model, pid_steering.gains, settings);
+    
+    // Keeping the best gains scored, Twiddle moves on to the next probe whatever the error
+    if (error < result.best_error) {
+      result.best_error = error;
+      result.gains = pid_steering.gains;
+    }
+    
+    // Twiddle scores the gains it set in the previous call with the accumulated error
+    pid_steering.ResetError();
+    pid_steering.sum_squared_error = error;
+    pid_steering.iterations = 1;
+    
+    pid_steering.Twiddle();
+    
+    result.episodes += 1;
+    result.rounds += 1;
+    
+  }
+  
+  result.gain_increments = pid_steering.gain_increments;
+  
+  return result;
+  
+}
+
+
+// Tunes the steering gains with twiddle, evaluating the probes of every tuned gain concurrently
+TuningResult TwiddleParallel(const Track &track, const VehicleModel &model,
+                             const EpisodeSettings &settings, long max_episodes, int threads) {
+  
+  Controller controller;
+  const PDController &pid_steering = controller.pid_steering;
+  
+  TuningResult result;
+  result.gains = pid_steering.gains;
+  result.gain_increments = pid_steering.gain_increments;
+  result.best_error = RunEpisode(track, model, result.gains, settings);
+  result.episodes = 1;
+  result.rounds = 0;
+  
+  std::vector<Gains> candidates;
+  std::vector<size_t> indices;
+  std::vector<double> errors;
+  
+  ThreadPool pool(threads);
+  
+  auto sum = [&result]() {
+    return result.gain_increments[0] + result.gain_increments[1] + result.gain_increments[2];
+  };
+  
+  while (sum() > kTuningThreshold && result.episodes < max_episodes) {
+    
+    // Probing each tuned gain in both directions, as twiddle's first and second order do
+    candidates.clear();
+    indices.clear();
+    
+    for (size_t i = 0; i < result.gains.size(); ++i) {
+      
+      if (i == kIntegralGain) {
+        continue;
+      }
+      
+      Gains increased = result.gains;
+      increased[i] += result.gain_increments[i];
+      
+      Gains decreased = result.gains;
+      decreased[i] -= result.gain_increments[i];
+      
+      // Ensuring that the PID gain stays positive
+      if (decreased[i] < 0.0) {
+        decreased[i] = 0.0;
+      }
+      
+      candidates.push_back(increased);
+      candidates.push_back(decreased);
+      indices.push_back(i);
+      indices.push_back(i);
+      
+    }
+    
+    RunEpisodes(track, model, candidates, settings, pool, errors);
+    
+    result.episodes += candidates.size();
+    result.rounds += 1;
+    
+    // Finding the best probe of each gain and of the round
+    std::array<double, 3> best_errors = {INFINITY, INFINITY, INFINITY};
+    size_t best = 0;
+    
+    for (size_t k = 0; k < candidates.size(); ++k) {
+      
+      best_errors[indices[k]] = fmin(best_errors[indices[k]], errors[k]);
+      
+      if (errors[k] < errors[best]) {
+        best = k;
+      }
+      
+    }
+    
+    // Decreasing the incrementing value of the gains that did not improve in either direction
+    for (size_t k = 0; k < candidates.size(); k += 2) {
+      
+      size_t i = indices[k];
+      
+      if (!(best_errors[i] < result.best_error)) {
+        result.gain_increments[i] *= 0.9;
+      }
+      
+    }
+    
+    // Accepting the best probe if it improved the error and increasing its incrementing value
+    if (errors[best] < result.best_error) {
+      result.best_error = errors[best];
+      result.gains = candidates[best];
+      result.gain_increments[indices[best]] *= 1.1;
+    }
+    
+  }
+  
+  return result;
+  
+}
+
+
+// Tunes the steering gains with an optimizer, one episode at a time
+TuningResult Optimize(const Track &track, const VehicleModel &model,
+                      const EpisodeSettings &settings, Optimizer &optimizer, long max_episodes) {
+  
+  TuningResult result;
+  result.episodes = 0;
+  result.rounds = 0;
+  
+  while (!optimizer.Converged() && result.episodes < max_episodes) {
+    
+    optimizer.Report(RunEpisode(track, model, optimizer.Next(), settings));
+    
+    result.episodes += 1;
+    result.rounds += 1;
+    result.history.push_back(optimizer.BestError());
+    
+  }
+  
+  result.gains = optimizer.Best();
+  result.gain_increments = optimizer.Steps();
+  result.best_error = optimizer.BestError();
+  
+  return result;
+  
+}
+
+
+// Episodes an optimizer took to bring its best error down to the target
+long EpisodesToReach(const TuningResult &result, double target) {
+  
+  for (size_t k = 0; k < result.history.size(); ++k) {
+    if (result.history[k] <= target) {
+      return long(k + 1);
+    }
+  }
+  
+  return -1;
+  
+}
@@ -0,0 +1,87 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "Simulator.h"
+#include "ThreadPool.h"
+
+class Optimizer;
+
+// Steering gains, Kp, Ki, Kd
+typedef std::array<double, 3> Gains;
+
+// Episodes used to score steering gains offline
+struct EpisodeSettings {
+  
+  // Ticks driven from each start waypoint
+  int ticks;
+  
+  // Number of start waypoints, evenly spaced around the track
+  int starts;
+  
+};
+
+// Default episode: four starts of 2000 ticks, a little over one lap each at the tuning speed
+EpisodeSettings DefaultEpisodeSettings();
+
+// Drives one episode with fixed steering gains and returns the mean squared cross track error
+// Steers with Controller::StepFixedGains, at the tuning speed and with the controller's reset rules
+// A start that is reset ends early and is charged kMaxCte^2 for each of its remaining ticks
+double RunEpisode(const Track &track, const VehicleModel &model,
+                  const Gains &gains, const EpisodeSettings &settings);
+
+// Scores each candidate with the same error as RunEpisode, one task per candidate and start
+// on the thread pool, so up to candidates x starts tasks can run concurrently
+// Starts that are reset end early, so the pool's work stealing keeps the threads busy
+void RunEpisodes(const Track &track, const VehicleModel &model,
+                 const std::vector<Gains> &candidates, const EpisodeSettings &settings,
+                 ThreadPool &pool, std::vector<double> &errors);
+
+// Result of a tuning run
+struct TuningResult {
+  
+  Gains gains;
+  Gains gain_increments;
+  double best_error;
+  
+  // Episodes driven and twiddle rounds taken
+  long episodes;
+  long rounds;
+  
+  // Best error after each episode, only recorded by Optimize
+  std::vector<double> history;
+  
+};
+
+// Tunes the steering gains with PDController::Twiddle, one episode at a time
+// Starts from the controller's initial steering gains and increments, and stops once the
+// sum of the increments falls to kTuningThreshold or max_episodes episodes have been driven
+// The result holds the best gains scored and their error, as TwiddleParallel's does, rather than
+// the gains of the last probe
+TuningResult TwiddleSequential(const Track &track, const VehicleModel &model,
+                               const EpisodeSettings &settings, long max_episodes);
+
+// Tunes the steering gains with twiddle, evaluating the +delta and -delta probes of every
+// tuned gain concurrently on a pool of the given number of threads
+// A round has four probes, Kp and Kd in both directions, so at most 4 x settings.starts
+// tasks run at once and threads beyond that sit idle
+// Each round accepts the best probe that improves the best error and grows its increment by 1.1,
+// and shrinks by 0.9 the increments of gains whose probes both failed
+// Stops under the same conditions as TwiddleSequential
+TuningResult TwiddleParallel(const Track &track, const VehicleModel &model,
+                             const EpisodeSettings &settings, long max_episodes, int threads);
+
+// Tunes the steering gains with an optimizer, one episode at a time
+// Stops once the optimizer has converged or max_episodes episodes have been driven
+// The result holds the best gains scored and the optimizer's final steps as increments
+TuningResult Optimize(const Track &track, const VehicleModel &model,
+                      const EpisodeSettings &settings, Optimizer &optimizer, long max_episodes);
+
+// Episodes an optimizer took to bring its best error down to the target
+// Returns -1 if it never did
+long EpisodesToReach(const TuningResult &result, double target);
+
+#endif // TUNING_H
@@ -1,223 +1,464 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
 #include <vector>
 #include <math.h>
+#include <uv.h>
 #include <uWS/uWS.h>
 
-#include "json.hpp"
+#include "Commands.h"
+#include "Controller.h"
+#include "Logger.h"
+#include "MessageHandler.h"
+#include "Metrics.h"
 #include "PID.h"
+#include "Pipeline.h"
+#include "Session.h"
+#include "StageTimer.h"
+#include "Telemetry.h"
+#include "Trace.h"
 
-using json = nlohmann::json;
 using namespace std;
 
-// For converting back and forth between radians and degrees.
-constexpr double pi() { return M_PI; }
-double deg2rad(double x) { return x * pi() / 180; }
-double rad2deg(double x) { return x * 180 / pi(); }
-
-// Checks if the SocketIO event has JSON data.
-// If there is data the JSON object in string format will be returned,
-// else the empty string "" will be returned.
-std::string hasData(std::string s) {
-  auto found_null = s.find("null");
-  auto b1 = s.find_first_of("[");
-  auto b2 = s.find_last_of("]");
-  
-  if (found_null != std::string::npos) {
-    return "";
+typedef uWS::WebSocket<uWS::SERVER>::PreparedMessage PreparedMessage;
+
+// Constant SocketIO events framed once per event loop thread
+// uWS reference counts prepared messages without synchronization, so loops do not share them
+thread_local PreparedMessage *reset_message;
+thread_local PreparedMessage *manual_message;
+
+// Session counters, metrics and twiddle progress across all event loops, served on /metrics
+MetricsRegistry metrics;
+
+// Page served on /metrics, rendered once a second off the event loops
+MetricsRenderer metrics_page(metrics);
+
+// Frames a constant message so that sending it is a single buffer write
+PreparedMessage *PrepareMessage(const char *msg, size_t length) {
+  
+  // uWS copies the data into the frame
+  return uWS::WebSocket<uWS::SERVER>::prepareMessage(const_cast<char *>(msg), length,
+                                                     uWS::OpCode::TEXT, false);
+  
+}
+
+void ResetSimulator(uWS::WebSocket<uWS::SERVER> ws) {
+  
+  ws.sendPrepared(reset_message);
+  
+}
+
+// Session of a connected simulator together with its socket
+// The socket lets the event loop send commands that come back from the control thread
+struct Connection : Session {
+  
+  uWS::WebSocket<uWS::SERVER> ws;
+  
+  Connection(long id, uWS::WebSocket<uWS::SERVER> ws) : Session(id), ws(ws) {}
+  
+};
+
+// Settings of the server, shared by all event loops
+struct ServerOptions {
+  
+  int port;
+  
+  // Number of event loop threads
+  int threads;
+  
+  // Running the controllers on a control thread per event loop
+  bool pipelined;
+  
+  // Sending one command for all the frames queued for a session
+  bool coalescing;
+  
+  // Seconds between latency reports, 0 disables the stage timers
+  int latency_interval;
+  
+};
+
+// Frees a connection once its controller will not run again
+void DeleteConnection(Connection *connection) {
+  
+  metrics.Release(connection->metrics);
+  delete connection;
+  
+}
+
+// Sends the reply to one message
+void SendReply(uWS::WebSocket<uWS::SERVER> ws, const Reply &reply, StageTimer &timer) {
+  
+  switch (reply.kind) {
+    
+    case ReplyKind::kSteer:
+      ws.send(reply.msg, reply.length, uWS::OpCode::TEXT);
+      break;
+    
+    case ReplyKind::kReset:
+      ResetSimulator(ws);
+      break;
+    
+    case ReplyKind::kManual:
+      ws.sendPrepared(manual_message);
+      break;
+    
+    case ReplyKind::kNone:
+      return;
+    
   }
   
-  else if (b1 != std::string::npos && b2 != std::string::npos) {
-    return s.substr(b1, b2 - b1 + 1);
+  timer.Lap(kStageSend);
+  
+}
+
+// Sends the commands computed by the control thread, run by the event loop when woken
+void SendCommands(uv_async_t *async) {
+  
+  ControlPipeline *pipeline = static_cast<ControlPipeline *>(async->data);
+  PipelineCommand command;
+  
+  while (pipeline->Receive(command)) {
+    
+    Connection *connection = static_cast<Connection *>(command.session);
+    connection->in_flight -= command.frames;
+    
+    // Freeing sessions whose socket closed once their last command is back
+    if (connection->closed) {
+      
+      if (connection->in_flight == 0) {
+        DeleteConnection(connection);
+      }
+      
+      continue;
+      
+    }
+    
+    StageTimer timer(pipeline->Histograms());
+    Reply reply;
+    MessageHandler::Serialize(command.command, reply, timer);
+    SendReply(connection->ws, reply, timer);
+    timer.Finish();
+    
   }
   
-  return "";
 }
 
-void ResetSimulator(uWS::WebSocket<uWS::SERVER> ws) {
+// Latency histograms of every event loop and the totals at the last report
+struct LatencyReport {
+  
+  std::vector<StageHistograms> *histograms;
+  std::vector<HistogramSnapshot> previous;
   
-  std::string msg = "42[\"reset\",{}]";
-  ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+};
+
+// Logs the percentiles of every stage since the previous report, run by the first event loop
+void ReportLatency(uv_timer_t *handle) {
+  
+  LatencyReport *report = static_cast<LatencyReport *>(handle->data);
+  
+  for (int stage = 0; stage < kStageCount; ++stage) {
+    
+    HistogramSnapshot total;
+    
+    for (StageHistograms &histograms : *report->histograms) {
+      total.Add(histograms.stages[stage].Snapshot());
+    }
+    
+    HistogramSnapshot interval = total.Since(report->previous[stage]);
+    report->previous[stage] = total;
+    
+    if (interval.total > 0) {
+      LOG_INFO(LogEvent::kLatency, stage, interval.Percentile(0.5), interval.Percentile(0.99));
+      LOG_INFO(LogEvent::kLatencyTail, stage, interval.Percentile(0.999), interval.Max());
+    }
+    
+  }
   
 }
 
-int main()
+// Runs one hub with its own event loop on the calling thread
+// Sessions stay on the loop that accepted their socket, so their controllers need no locking
+// Returns false if the hub could not listen to the port
+// The stages of the loop are timed into histograms[loop] when latency reports are enabled
+bool RunEventLoop(int loop, const ServerOptions &options, TraceWriter &trace,
+                  std::vector<StageHistograms> &histograms, std::vector<PipelineCounters> &pipelines)
 {
   uWS::Hub h;
   
-  // Creating PID controllers
-  PID pid_steering, pid_throttle;
-  
-  // Initializing the PID controllers
-  // Kp, Ki, Kd, Kp_inc, Ki_inc, Kd_inc
-  pid_steering.Init(0.05, 0.0, 0.0, 0.05, 0.0, 0.5);
-  pid_throttle.Init(0.2, 0.0, 3.0, 0.0, 0.0, 0.0);
-  
-  int total_iterations;
-  total_iterations = 0;
-  
-  h.onMessage([&pid_steering, &pid_throttle, &total_iterations]
-              (uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
-                
-    // "42" at the start of the message means there's a websocket message event.
-    // The 4 signifies a websocket message
-    // The 2 signifies a websocket event
-    
-    if (length && length > 2 && data[0] == '4' && data[1] == '2') {
-      
-      auto s = hasData(std::string(data).substr(0, length));
-      
-      // Start autonomous mode
-      if (s != "") {
-        
-        auto j = json::parse(s);
-        std::string event = j[0].get<std::string>();
-        
-        if (event == "telemetry") {
-          
-          // j[1] is the data JSON object
-          double cte = std::stod(j[1]["cte"].get<std::string>());
-          double speed = std::stod(j[1]["speed"].get<std::string>());
-          double angle = std::stod(j[1]["steering_angle"].get<std::string>());
-          
-          double steer_value, throttle_value, target_speed, speed_error;
-          
-          pid_steering.UpdateError(cte);
-          
-          // Normalizing the steering value
-          steer_value = pid_steering.TotalError() / -deg2rad(25.0);
-          
-          total_iterations += 1;
-          
-          // Starting optimizing mode if the sum of the gain increments is greater than the set threshold
-          if (pid_steering.CalculateSum() > 0.1) {
-            
-            cout << "Optimizing" << endl;
-            
-            // Optimizing the PID gains while trying to maintain a constant speed
-            target_speed = 40;
-            speed_error = target_speed - speed;
-            pid_throttle.UpdateError(speed_error);
-            throttle_value = pid_throttle.TotalError();
-            
-            // Resetting the simulator if the car drives off the track or gets stuck
-            if ((fabs(cte) > 4.5 && total_iterations > 100) || (speed < 5.0 && total_iterations > 100)) {
-              
-              cout << "Resetting" << endl;
-              
-              pid_steering.Twiddle();
-              ResetSimulator(ws);
-              pid_steering.ResetError();
-              total_iterations = 0;
-              
-              // Skipping output to simulator
-              goto end_cycle;
-              
-            }
-            
-            else if (total_iterations > 400) {
-              
-              cout << "Twiddling" << endl;
-              
-              pid_steering.Twiddle();
-              total_iterations = 0;
-              
-            }
-            
-            cout << "Best Error: " << pid_steering.best_error << " Current Error: " << pid_steering.CalculateError() << endl;
-            
-            switch (pid_steering.i) {
-                
-              case 0: {
-                cout << "Tuning Proportional Gain - Twiddle Order: " << pid_steering.order << endl;
-                break;
-              }
-                
-              case 1: {
-                cout << "Tuning Integral Gain - Twiddle Order: " << pid_steering.order << endl;
-                break;
-              }
-                
-              case 2: {
-                cout << "Tuning Derivative Gain - Twiddle Order: " << pid_steering.order << endl;
-                break;
-              }
-                
-            } // End switch
-            
-            cout << "P inc: " << pid_steering.gain_increments[0] << " I inc: " << pid_steering.gain_increments[1] << " D inc: " << pid_steering.gain_increments[2] << endl;
-            
-          } // End optimizing mode
-          
-          else {
-            
-            cout << "Optimized" << endl;
-            
-            target_speed = 60;
-            speed_error = target_speed - speed;
-            pid_throttle.UpdateError(speed_error);
-            throttle_value = pid_throttle.TotalError() * (1.0 / (1.0 + fabs(angle)));
-            
-          }
-          
-          cout << "P: " << pid_steering.gains[0] << " I: " << pid_steering.gains[1] << " D: " << pid_steering.gains[2] << endl;
-          cout << "CTE: " << cte << " Steering Value: " << rad2deg(steer_value) << " degrees" << endl;
-          cout << "Throttle Value: " << throttle_value << endl;
-          cout << endl;
-          
-          json msgJson;
-          msgJson["steering_angle"] = steer_value;
-          msgJson["throttle"] = throttle_value;
-          auto msg = "42[\"steer\"," + msgJson.dump() + "]";
-          ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-          
-        }
-        
-      } // End autonomous mode
+  bool pipelined = options.pipelined;
+  StageHistograms *stages = options.latency_interval > 0 ? &histograms[loop] : nullptr;
+  
+  reset_message = PrepareMessage(kResetCommand, sizeof(kResetCommand) - 1);
+  manual_message = PrepareMessage(kManualCommand, sizeof(kManualCommand) - 1);
+  
+  // Waking the event loop from the control thread when commands are ready
+  uv_async_t commands_ready;
+  ControlPipeline pipeline(trace, [](void *data) { uv_async_send(static_cast<uv_async_t *>(data)); },
+                           &commands_ready, options.coalescing, stages,
+                           pipelines[loop]);
+  
+  if (pipelined) {
+    uv_async_init(h.getLoop(), &commands_ready, SendCommands);
+    commands_ready.data = &pipeline;
+    pipeline.Start();
+  }
+  
+  // Reporting the latency of all event loops from the first one
+  uv_timer_t latency_timer;
+  LatencyReport latency_report;
+  
+  if (loop == 0 && stages != nullptr) {
+    latency_report.histograms = &histograms;
+    latency_report.previous.resize(kStageCount);
+    uv_timer_init(h.getLoop(), &latency_timer);
+    latency_timer.data = &latency_report;
+    uv_timer_start(&latency_timer, ReportLatency, options.latency_interval * 1000, options.latency_interval * 1000);
+  }
+  
+  MessageHandler handler(trace);
+  
+  h.onMessage([&handler, &pipeline, pipelined, stages](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
+    
+    Session *session = static_cast<Session *>(ws.getUserData());
+    
+    if (session == nullptr) {
+      return;
+    }
+    
+    StageTimer timer(stages);
+    Reply reply;
+    
+    // The command is sent once the control thread returns it
+    if (pipelined) {
       
-      // Start manual mode
-      else {
-        
-        std::string msg = "42[\"manual\",{}]";
-        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-        
-      } // End manual mode
+      Telemetry telemetry;
+      MessageKind kind = handler.Read(data, length, telemetry, timer);
       
+      if (kind == MessageKind::kTelemetry) {
+        pipeline.Submit(session, telemetry);
+      }
+      
+      reply.kind = kind == MessageKind::kManual ? ReplyKind::kManual : ReplyKind::kNone;
+      
+    }
+    
+    else {
+      handler.Handle(*session, data, length, reply, timer);
     }
     
-  end_cycle:
-    ;
-                
+    SendReply(ws, reply, timer);
+    timer.Finish();
+    
   });
-
+  
   h.onHttpRequest([](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t, size_t) {
     const std::string s = "<h1>Hello world!</h1>";
     
-    if (req.getUrl().valueLength == 1) {
+    uWS::Header url = req.getUrl();
+    
+    if (url.valueLength == 1) {
       res->end(s.data(), s.length());
     }
+    
+    // The page is rendered by its own thread, so scraping only copies it
+    else if (url.valueLength == 8 && strncmp(url.value, "/metrics", 8) == 0) {
+      
+      std::shared_ptr<const std::string> body = metrics_page.Body();
+      
+      res->end(body->data(), body->length());
+      
+    }
+    
     else {
       res->end(nullptr, 0);
     }
     
   });
-
-  h.onConnection([&h](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
-    std::cout << "Connected!!!" << std::endl;
+  
+  h.onConnection([](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
+    
+    // Looked up through the socket in onMessage without any search
+    Session *session = new Connection(metrics.OpenSession(), ws);
+    session->metrics = metrics.Acquire(session->id);
+    ws.setUserData(session);
+    long open = metrics.SessionsOpen();
+    
+    LOG_INFO(LogEvent::kConnected, session->id, open);
+    
   });
-
-  h.onDisconnection([&h](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+  
+  h.onDisconnection([&pipeline, pipelined](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+    
+    Connection *connection = static_cast<Connection *>(ws.getUserData());
+    
     ws.close();
-    std::cout << "Disconnected" << std::endl;
+    
+    if (connection != nullptr) {
+      
+      long open = metrics.CloseSession();
+      LOG_INFO(LogEvent::kDisconnected, connection->id, open);
+      
+      if (pipelined) {
+        LOG_INFO(LogEvent::kPipeline, pipeline.Submitted(), pipeline.Dropped(), pipeline.Stale());
+        LOG_INFO(LogEvent::kCoalesced, pipeline.Coalesced());
+      }
+      
+      ws.setUserData(nullptr);
+      
+      // The control thread may still be running frames of the session
+      if (connection->in_flight > 0) {
+        connection->closed = true;
+      }
+      
+      else {
+        DeleteConnection(connection);
+      }
+      
+    }
+    
   });
-
-  int port = 4567;
-  if (h.listen(port)) {
-    std::cout << "Listening to port " << port << std::endl;
+  
+  // The kernel spreads new connections over the loops listening to the same port
+  int listen_options = options.threads > 1 ? uS::ListenOptions::REUSE_PORT : 0;
+  
+  if (h.listen(options.port, nullptr, listen_options)) {
+    
+    // Logging once for all event loops
+    if (loop == 0) {
+      LOG_INFO(LogEvent::kListening, options.port);
+    }
+    
   }
   else {
     std::cerr << "Failed to listen to port" << std::endl;
-    return -1;
+    uWS::WebSocket<uWS::SERVER>::finalizeMessage(reset_message);
+    uWS::WebSocket<uWS::SERVER>::finalizeMessage(manual_message);
+    return false;
   }
   
   h.run();
+  
+  pipeline.Stop();
+  
+  uWS::WebSocket<uWS::SERVER>::finalizeMessage(reset_message);
+  uWS::WebSocket<uWS::SERVER>::finalizeMessage(manual_message);
+  
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  ServerOptions options;
+  options.port = 4567;
+  
+  // Number of event loop threads, each with its own hub, set with --threads <n>
+  options.threads = 1;
+  
+  // Running the controllers on a control thread per event loop, set with --pipeline
+  options.pipelined = false;
+  
+  // Sending one command for all the frames queued for a session, set with --coalesce
+  // Implies --pipeline
+  options.coalescing = false;
+  
+  // Timing the stages of one tick in 16 and logging their latency every <seconds>,
+  // set with --latency <seconds>
+  options.latency_interval = 0;
+  
+  // Recording a binary flight trace if requested with --trace <file>
+  // With several event loops each loop writes <file>.<loop>
+  const char *trace_path = nullptr;
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--trace") == 0 && n + 1 < argc) {
+      trace_path = argv[++n];
+    }
+    
+    else if (strcmp(argv[n], "--threads") == 0 && n + 1 < argc) {
+      options.threads = std::max(1, atoi(argv[++n]));
+    }
+    
+    else if (strcmp(argv[n], "--pipeline") == 0) {
+      options.pipelined = true;
+    }
+    
+    else if (strcmp(argv[n], "--coalesce") == 0) {
+      options.pipelined = true;
+      options.coalescing = true;
+    }
+    
+    else if (strcmp(argv[n], "--latency") == 0 && n + 1 < argc) {
+      options.latency_interval = std::max(1, atoi(argv[++n]));
+    }
+    
+  }
+  
+  int threads = options.threads;
+  
+  std::vector<TraceWriter> traces(threads);
+  
+  if (trace_path != nullptr) {
+    
+    for (int loop = 0; loop < threads; ++loop) {
+      
+      std::string path = threads == 1 ? std::string(trace_path) : std::string(trace_path) + "." + std::to_string(loop);
+      
+      if (!traces[loop].Open(path.c_str())) {
+        std::cerr << "Failed to open trace file " << path << std::endl;
+        return -1;
+      }
+      
+    }
+    
+  }
+  
+  std::vector<StageHistograms> histograms(options.latency_interval > 0 ? threads : 0);
+  std::vector<PipelineCounters> pipelines(threads);
+  
+  metrics.Attach(&histograms, options.pipelined ? &pipelines : nullptr);
+  metrics_page.Start();
+  
+  // Formatting and printing happen on the logger's own thread
+  Logger::Instance().Start();
+  
+  bool listening = true;
+  
+  if (threads == 1) {
+    listening = RunEventLoop(0, options, traces[0], histograms, pipelines);
+  }
+  
+  else {
+    
+    std::vector<std::thread> loops;
+    std::atomic<bool> failed(false);
+    
+    for (int loop = 0; loop < threads; ++loop) {
+      loops.emplace_back([loop, &options, &traces, &histograms, &pipelines, &failed]() {
+        if (!RunEventLoop(loop, options, traces[loop], histograms, pipelines)) {
+          failed = true;
+        }
+      });
+    }
+    
+    for (std::thread &loop : loops) {
+      loop.join();
+    }
+    
+    listening = !failed;
+    
+  }
+  
+  metrics_page.Stop();
+  Logger::Instance().Stop();
+  
+  for (TraceWriter &trace : traces) {
+    trace.Close();
+  }
+  
+  return listening ? 0 : -1;
 }
@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <uv.h>
+#include <uWS/uWS.h>
+
+#include "LatencyHistogram.h"
+#include "Simulator.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Longest telemetry event written by WriteTelemetry including the terminating null
+const size_t kMaxTelemetryLength = 256;
+
+// Settings of the client
+struct ClientOptions {
+  
+  std::string uri;
+  
+  // Number of virtual cars, each with its own connection
+  int cars;
+  
+  // Telemetry frames per second per car, 0 sends the next frame as soon as the reply arrives
+  double rate;
+  
+  // Seconds to drive once connected
+  double duration;
+  
+  // Recorded telemetry replayed instead of the vehicle model, one list of records per
+  // recorded session in order of their first tick, empty if none
+  std::vector<std::vector<TraceRecord>> sessions;
+  
+};
+
+// One virtual car
+// Drives the headless vehicle model with the commands it receives, or replays a trace
+struct Car {
+  
+  int id;
+  
+  Simulator simulator;
+  
+  // Replayed records and the next one to send, unused without a trace
+  const std::vector<TraceRecord> *trace;
+  size_t cursor;
+  
+  // Set when the car is at rest after connecting or a reset, so the next frame observes it
+  bool at_rest;
+  
+  uWS::WebSocket<uWS::CLIENT> ws;
+  bool connected;
+  
+  // Latest command, applied on the next tick
+  double steering;
+  double throttle;
+  
+  // Send times of the frames still waiting for a reply, oldest first
+  std::deque<uint64_t> sent;
+  
+  // Round-trip time from sending a frame to receiving its reply
+  LatencyHistogram rtt;
+  
+  // Counters
+  long frames;
+  long steers;
+  long resets;
+  long manuals;
+  
+  // Sends frames at the configured rate
+  uv_timer_t timer;
+  
+  // Constructor
+  Car(int id, const std::vector<TraceRecord> *trace)
+    : id(id), simulator(DefaultTrack(), DefaultVehicleModel()), trace(trace), cursor(0), at_rest(true), connected(false),
+      steering(0.0), throttle(0.0), frames(0), steers(0), resets(0), manuals(0) {}
+  
+};
+
+
+// Steady clock time in nanoseconds
+static uint64_t Now() {
+  
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+  
+}
+
+
+// Writes the 42["telemetry",{...}] SocketIO event the Unity simulator sends
+// Values are quoted strings with 4 decimals, as in the simulator
+// Returns the length of the message
+static size_t WriteTelemetry(char *buffer, const Telemetry &telemetry, double throttle) {
+  
+  int length = snprintf(buffer, kMaxTelemetryLength,
+                        "42[\"telemetry\",{\"steering_angle\":\"%.4f\",\"throttle\":\"%.4f\","
+                        "\"speed\":\"%.4f\",\"cte\":\"%.4f\"}]",
+                        telemetry.steering_angle, throttle, telemetry.speed, telemetry.cte);
+  
+  return size_t(length);
+  
+}
+
+
+// Reads the number following a key of a steer command
+// Returns false if the key is missing
+static bool ReadValue(const char *data, size_t length, const char *key, double &value) {
+  
+  std::string message(data, length);
+  size_t position = message.find(key);
+  
+  if (position == std::string::npos) {
+    return false;
+  }
+  
+  value = strtod(message.c_str() + position + strlen(key), nullptr);
+  
+  return true;
+  
+}
+
+
+// Splits the records of a trace by session, in order of each session's first tick
+static void SplitSessions(const std::vector<TraceRecord> &records, std::vector<std::vector<TraceRecord>> &sessions) {
+  
+  std::map<uint32_t, size_t> index;
+  
+  for (const TraceRecord &record : records) {
+    
+    auto position = index.find(record.session);
+    
+    if (position == index.end()) {
+      position = index.emplace(record.session, sessions.size()).first;
+      sessions.emplace_back();
+    }
+    
+    sessions[position->second].push_back(record);
+    
+  }
+  
+}
+
+
+// Advances the car by one tick and sends its telemetry
+static void SendTelemetry(Car &car) {
+  
+  if (!car.connected) {
+    return;
+  }
+  
+  Telemetry telemetry;
+  
+  if (car.trace != nullptr) {
+    const TraceRecord &record = (*car.trace)[car.cursor];
+    telemetry.cte = record.cte;
+    telemetry.speed = record.speed;
+    telemetry.steering_angle = record.angle;
+    car.cursor = (car.cursor + 1) % car.trace->size();
+  }
+  
+  else if (car.at_rest) {
+    telemetry = car.simulator.Observe();
+    car.at_rest = false;
+  }
+  
+  else {
+    telemetry = car.simulator.Step(car.steering, car.throttle);
+  }
+  
+  char msg[kMaxTelemetryLength];
+  size_t msg_length = WriteTelemetry(msg, telemetry, car.throttle);
+  
+  car.sent.push_back(Now());
+  car.frames += 1;
+  
+  car.ws.send(msg, msg_length, uWS::OpCode::TEXT);
+  
+}
+
+
+// Handles a reply of the controller
+// The server answers every frame once and in order, so a reply belongs to the oldest frame
+// still waiting; with --coalesce on the server the times are upper bounds
+static void ReceiveReply(Car &car, const char *data, size_t length, bool lockstep) {
+  
+  if (!car.sent.empty()) {
+    car.rtt.Record(Now() - car.sent.front());
+    car.sent.pop_front();
+  }
+  
+  if (length > 9 && strncmp(data, "42[\"steer\"", 10) == 0) {
+    ReadValue(data, length, "\"steering_angle\":", car.steering);
+    ReadValue(data, length, "\"throttle\":", car.throttle);
+    car.steers += 1;
+  }
+  
+  // The Unity simulator puts the car back at the start, a replayed trace carries on
+  else if (length > 9 && strncmp(data, "42[\"reset\"", 10) == 0) {
+    car.simulator.Reset();
+    car.steering = 0.0;
+    car.throttle = 0.0;
+    car.at_rest = true;
+    car.resets += 1;
+  }
+  
+  else if (length > 10 && strncmp(data, "42[\"manual\"", 11) == 0) {
+    car.manuals += 1;
+  }
+  
+  if (lockstep) {
+    SendTelemetry(car);
+  }
+  
+}
+
+
+// Prints the round-trip times and counters of a car or of all cars
+static void ReportCar(const char *name, const HistogramSnapshot &rtt, long frames, long steers,
+                      long resets, long manuals, double seconds) {
+  
+  printf("%-8s %8ld frames %8.0f frames/s %8ld steer %6ld reset %6ld manual  rtt us p50 %8.1f p99 %8.1f p99.9 %8.1f max %8.1f\n",
+         name, frames, frames / seconds, steers, resets, manuals, rtt.Percentile(0.5) / 1e3,
+         rtt.Percentile(0.99) / 1e3, rtt.Percentile(0.999) / 1e3, rtt.Max() / 1e3);
+  
+}
+
+
+// Stands in for the Unity simulator: connects M virtual cars to the controller and drives them
+// Usage: sim_client [--uri ws://127.0.0.1:4567] [--cars M] [--rate HZ] [--duration S] [--trace FILE]
+// Each car drives the headless vehicle model with the commands it receives, or replays the
+// telemetry of one session of a trace recorded with pid --trace. With --rate 0 each car sends its next frame
+// as soon as its reply arrives, which measures the most the server can sustain.
+int main(int argc, char *argv[]) {
+  
+  ClientOptions options;
+  options.uri = "ws://127.0.0.1:4567";
+  options.cars = 1;
+  options.rate = 0.0;
+  options.duration = 10.0;
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--uri") == 0 && n + 1 < argc) {
+      options.uri = argv[++n];
+    }
+    
+    else if (strcmp(argv[n], "--cars") == 0 && n + 1 < argc) {
+      options.cars = max(1, atoi(argv[++n]));
+    }
+    
+    else if (strcmp(argv[n], "--rate") == 0 && n + 1 < argc) {
+      options.rate = max(0.0, atof(argv[++n]));
+    }
+    
+    else if (strcmp(argv[n], "--duration") == 0 && n + 1 < argc) {
+      options.duration = max(0.1, atof(argv[++n]));
+    }
+    
+    else if (strcmp(argv[n], "--trace") == 0 && n + 1 < argc) {
+      
+      const char *path = argv[++n];
+      std::vector<TraceRecord> records;
+      
+      if (!ReadTrace(path, records) || records.empty()) {
+        fprintf(stderr, "Failed to read trace file %s\n", path);
+        return -1;
+      }
+      
+      SplitSessions(records, options.sessions);
+      
+    }
+    
+    else {
+      fprintf(stderr, "Usage: %s [--uri URI] [--cars M] [--rate HZ] [--duration S] [--trace FILE]\n", argv[0]);
+      return -1;
+    }
+    
+  }
+  
+  bool lockstep = options.rate == 0.0;
+  
+  uWS::Hub h;
+  
+  std::vector<std::unique_ptr<Car>> cars;
+  
+  // Each car replays one recorded session, the sessions are reused once every one has a car
+  for (int id = 1; id <= options.cars; ++id) {
+    const std::vector<TraceRecord> *trace =
+      options.sessions.empty() ? nullptr : &options.sessions[(id - 1) % options.sessions.size()];
+    cars.emplace_back(new Car(id, trace));
+  }
+  
+  int connected = 0;
+  int failed = 0;
+  uint64_t start = 0;
+  
+  h.onConnection([&](uWS::WebSocket<uWS::CLIENT> ws, uWS::HttpRequest req) {
+    
+    Car &car = *static_cast<Car *>(ws.getUserData());
+    car.ws = ws;
+    car.connected = true;
+    
+    // Timing from the first connection
+    if (connected++ == 0) {
+      start = Now();
+    }
+    
+    if (lockstep) {
+      SendTelemetry(car);
+    }
+    
+    else {
+      uint64_t period = max<uint64_t>(1, uint64_t(1000.0 / options.rate));
+      uv_timer_init(h.getLoop(), &car.timer);
+      car.timer.data = &car;
+      uv_timer_start(&car.timer, [](uv_timer_t *timer) { SendTelemetry(*static_cast<Car *>(timer->data)); },
+                     period, period);
+    }
+    
+  });
+  
+  h.onMessage([lockstep](uWS::WebSocket<uWS::CLIENT> ws, char *data, size_t length, uWS::OpCode opCode) {
+    
+    ReceiveReply(*static_cast<Car *>(ws.getUserData()), data, length, lockstep);
+    
+  });
+  
+  h.onDisconnection([lockstep](uWS::WebSocket<uWS::CLIENT> ws, int code, char *message, size_t length) {
+    
+    Car &car = *static_cast<Car *>(ws.getUserData());
+    car.connected = false;
+    
+    if (!lockstep) {
+      uv_timer_stop(&car.timer);
+      uv_close(reinterpret_cast<uv_handle_t *>(&car.timer), nullptr);
+    }
+    
+  });
+  
+  h.onError([&failed](void *user) {
+    
+    Car &car = *static_cast<Car *>(user);
+    fprintf(stderr, "Car %d failed to connect\n", car.id);
+    failed += 1;
+    
+  });
+  
+  for (std::unique_ptr<Car> &car : cars) {
+    h.connect(options.uri, car.get());
+  }
+  
+  // Disconnecting every car once the duration has elapsed
+  uv_timer_t stop_timer;
+  stop_timer.data = &cars;
+  uv_timer_init(h.getLoop(), &stop_timer);
+  uv_timer_start(&stop_timer, [](uv_timer_t *timer) {
+    
+    for (std::unique_ptr<Car> &car : *static_cast<std::vector<std::unique_ptr<Car>> *>(timer->data)) {
+      if (car->connected) {
+        car->ws.close();
+      }
+    }
+    
+    uv_close(reinterpret_cast<uv_handle_t *>(timer), nullptr);
+    
+  }, uint64_t(options.duration * 1000.0), 0);
+  
+  h.run();
+  
+  double seconds = start == 0 ? options.duration : (Now() - start) / 1e9;
+  
+  if (connected == 0) {
+    fprintf(stderr, "No car connected to %s\n", options.uri.c_str());
+    return -1;
+  }
+  
+  printf("%d cars connected to %s, %d failed, %s, %.1f s\n", connected, options.uri.c_str(), failed,
+         lockstep ? "lockstep" : (std::to_string(options.rate) + " frames/s per car").c_str(), seconds);
+  
+  HistogramSnapshot total_rtt;
+  long frames = 0, steers = 0, resets = 0, manuals = 0;
+  
+  for (std::unique_ptr<Car> &car : cars) {
+    
+    HistogramSnapshot rtt = car->rtt.Snapshot();
+    std::string name = "car " + std::to_string(car->id);
+    
+    ReportCar(name.c_str(), rtt, car->frames, car->steers, car->resets, car->manuals, seconds);
+    
+    total_rtt.Add(rtt);
+    frames += car->frames;
+    steers += car->steers;
+    resets += car->resets;
+    manuals += car->manuals;
+    
+  }
+  
+  ReportCar("all", total_rtt, frames, steers, resets, manuals, seconds);
+  
+  return failed == 0 ? 0 : -1;
+  
+}
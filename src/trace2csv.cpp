@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Trace.h"
+
+// Converts a binary flight trace to CSV
+// Usage: trace2csv trace.bin > trace.csv
+int main(int argc, char *argv[]) {
+  
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+    return -1;
+  }
+  
+  FILE *file = fopen(argv[1], "rb");
+  
+  if (file == nullptr) {
+    fprintf(stderr, "Failed to open %s\n", argv[1]);
+    return -1;
+  }
+  
+  TraceHeader header;
+  
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0) {
+    fprintf(stderr, "%s is not a trace file\n", argv[1]);
+    fclose(file);
+    return -1;
+  }
+  
+  if (header.version != kTraceVersion || header.record_size != sizeof(TraceRecord)) {
+    fprintf(stderr, "Unsupported trace version %u\n", header.version);
+    fclose(file);
+    return -1;
+  }
+  
+  printf("timestamp,session,cte,speed,angle,steer,throttle,kp,ki,kd,best_error,current_error,index,order,optimizing,reset,twiddle\n");
+  
+  TraceRecord record;
+  uint64_t count = 0;
+  
+  while (count < header.record_count && fread(&record, sizeof(record), 1, file) == 1) {
+    
+    printf("%llu,%u,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%d,%d,%d,%d,%d\n",
+           static_cast<unsigned long long>(record.timestamp), record.session,
+           record.cte, record.speed, record.angle, record.steer, record.throttle,
+           record.gains[0], record.gains[1], record.gains[2],
+           record.best_error, record.current_error,
+           record.index, record.order,
+           (record.flags & kTraceOptimizing) != 0,
+           (record.flags & kTraceReset) != 0,
+           (record.flags & kTraceTwiddle) != 0);
+    
+    count += 1;
+    
+  }
+  
+  fclose(file);
+  
+  if (count != header.record_count) {
+    fprintf(stderr, "Trace truncated after %llu of %llu records\n",
+            static_cast<unsigned long long>(count), static_cast<unsigned long long>(header.record_count));
+    return -1;
+  }
+  
+  return 0;
+  
+}
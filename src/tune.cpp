@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Controller.h"
+#include "Optimizer.h"
+#include "Simulator.h"
+#include "Tuning.h"
+
+using namespace std;
+
+// Prints a tuning result and returns its wall time
+static double ReportTuning(const string &name, const TuningResult &result, double seconds) {
+  
+  cout << name << ": " << result.episodes << " episodes in " << result.rounds << " rounds, "
+       << seconds << " s" << endl;
+  cout << "  P: " << result.gains[0] << " I: " << result.gains[1] << " D: " << result.gains[2]
+       << " Best Error: " << result.best_error << endl;
+  
+  return seconds;
+  
+}
+
+
+// Tunes the steering gains with sequential twiddle
+static double TuneSequential(const EpisodeSettings &settings, long episodes) {
+  
+  auto start = chrono::steady_clock::now();
+  TuningResult result = TwiddleSequential(DefaultTrack(), DefaultVehicleModel(), settings, episodes);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  
+  return ReportTuning("Sequential twiddle", result, seconds);
+  
+}
+
+
+// Tunes the steering gains with parallel twiddle
+static double TuneParallel(const EpisodeSettings &settings, long episodes, int threads) {
+  
+  auto start = chrono::steady_clock::now();
+  TuningResult result = TwiddleParallel(DefaultTrack(), DefaultVehicleModel(), settings, episodes, threads);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  
+  return ReportTuning("Parallel twiddle (" + to_string(threads) + " threads)", result, seconds);
+  
+}
+
+
+// Tunes the steering gains with an optimizer, starting from the controller's steering gains
+// Nelder-Mead's initial simplex spans twiddle's initial increments
+static TuningResult TuneWith(const string &method, const EpisodeSettings &settings, long episodes) {
+  
+  Controller controller;
+  const PDController &pid_steering = controller.pid_steering;
+  
+  TwiddleOptimizer twiddle(pid_steering);
+  NelderMeadOptimizer nelder_mead(pid_steering.gains, pid_steering.gain_increments);
+  
+  Optimizer &optimizer = method == "nelder-mead" ? static_cast<Optimizer &>(nelder_mead) : twiddle;
+  
+  auto start = chrono::steady_clock::now();
+  TuningResult result = Optimize(DefaultTrack(), DefaultVehicleModel(), settings, optimizer, episodes);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  
+  ReportTuning(optimizer.Name(), result, seconds);
+  
+  return result;
+  
+}
+
+
+// Compares twiddle and Nelder-Mead on the same episodes
+// Convergence is compared as the episodes each takes to come within 1% of the worse final error
+static void CompareOptimizers(const EpisodeSettings &settings, long episodes) {
+  
+  TuningResult twiddle = TuneWith("twiddle", settings, episodes);
+  TuningResult nelder_mead = TuneWith("nelder-mead", settings, episodes);
+  
+  double target = 1.01 * max(twiddle.best_error, nelder_mead.best_error);
+  
+  cout << "Episodes to reach error " << target << ": Twiddle " << EpisodesToReach(twiddle, target)
+       << " Nelder-Mead " << EpisodesToReach(nelder_mead, target) << endl;
+  
+}
+
+
+// Tunes the steering gains with twiddle on the headless simulator
+// Usage: pid_tune [--ticks N] [--mode drive|sequential|parallel|compare|twiddle|nelder-mead|optimizers]
+//                 [--threads N] [--episodes N]
+// drive runs the application's controller for --ticks ticks, twiddling as it drives
+// sequential and parallel tune offline with fixed episodes, compare runs both
+// twiddle and nelder-mead tune offline through the optimizer interface, optimizers compares them
+int main(int argc, char *argv[]) {
+  
+  long ticks = 1000000;
+  long episodes = 2000;
+  int threads = max(1u, thread::hardware_concurrency());
+  string mode = "drive";
+  
+  for (int n = 1; n < argc; ++n) {
+    
+    if (strcmp(argv[n], "--ticks") == 0 && n + 1 < argc) {
+      ticks = atol(argv[++n]);
+    }
+    
+    else if (strcmp(argv[n], "--mode") == 0 && n + 1 < argc) {
+      mode = argv[++n];
+    }
+    
+    else if (strcmp(argv[n], "--threads") == 0 && n + 1 < argc) {
+      threads = max(1, atoi(argv[++n]));
+    }
+    
+    else if (strcmp(argv[n], "--episodes") == 0 && n + 1 < argc) {
+      episodes = atol(argv[++n]);
+    }
+    
+    else {
+      cerr << "Usage: " << argv[0]
+           << " [--ticks N] [--mode drive|sequential|parallel|compare|twiddle|nelder-mead|optimizers]"
+           << " [--threads N] [--episodes N]" << endl;
+      return -1;
+    }
+    
+  }
+  
+  EpisodeSettings settings = DefaultEpisodeSettings();
+  
+  if (mode == "sequential") {
+    TuneSequential(settings, episodes);
+    return 0;
+  }
+  
+  else if (mode == "parallel") {
+    TuneParallel(settings, episodes, threads);
+    return 0;
+  }
+  
+  else if (mode == "compare") {
+    double sequential_seconds = TuneSequential(settings, episodes);
+    double parallel_seconds = TuneParallel(settings, episodes, threads);
+    cout << "Speedup: " << sequential_seconds / parallel_seconds << "x" << endl;
+    return 0;
+  }
+  
+  else if (mode == "twiddle" || mode == "nelder-mead") {
+    TuneWith(mode, settings, episodes);
+    return 0;
+  }
+  
+  else if (mode == "optimizers") {
+    CompareOptimizers(settings, episodes);
+    return 0;
+  }
+  
+  else if (mode != "drive") {
+    cerr << "Unknown mode " << mode << endl;
+    return -1;
+  }
+  
+  Simulator simulator(DefaultTrack(), DefaultVehicleModel());
+  
+  Controller controller;
+  controller.logging = false;
+  
+  auto start = chrono::steady_clock::now();
+  DriveStatistics statistics = Drive(simulator, controller, ticks);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  
+  double simulated_seconds = statistics.ticks * simulator.TickSeconds();
+  
+  cout << "Ticks: " << statistics.ticks << " Resets: " << statistics.resets << endl;
+  cout << "P: " << controller.pid_steering.gains[0] << " I: " << controller.pid_steering.gains[1]
+       << " D: " << controller.pid_steering.gains[2] << endl;
+  cout << "Best Error: " << controller.pid_steering.best_error << endl;
+  cout << "Wall time: " << seconds << " s for " << simulated_seconds << " s of driving ("
+       << simulated_seconds / seconds << "x real time, " << statistics.ticks / seconds << " ticks/s)" << endl;
+  
+  return 0;
+  
+}